@@ -0,0 +1,201 @@
+#include "mock_adapter.h"
+#include "rule_generator.h"
+#include "script_interpreter.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Benchmarks of the interpreter on generated rule files and a mock node graph
+// ===========================================================================
+//   Bench replicate <template.rul> <copies> <out.rul>     e.g. rules\engine.rul 300 times for the load and engine runs
+//   Bench nested <functions> <depth> <out.rul>            deeply nested AND/OR/NOT conditions for the parser
+//   Bench load [options] <runs> <file>...                 best time of a Load into a new interpreter
+//   Bench execute [options] <bytecode|closures|tree> <nodes> <runs> <file>... [-- <function>...]
+//                                                         time of 'runs' Executes of all (or the given) functions
+// options:
+//   -lazy          SetLazyParsing(true)
+//   -threads N     SetLoadThreads(N)
+//   -inline N      SetInlining(N)
+//   -memo N        SetMemoization(N)
+//
+// Rule output goes to stdout and times to stderr, so "Bench execute ... > nul" shows only the times.
+// rules\engine.rul is the template of the load and engine runs, rules\calls.rul a call-heavy and
+// rules\errors.rul an error-heavy rule set: missing attributes, undefined variables, bad arity, unknown functions.
+
+namespace
+{
+    struct Options
+    {
+        bool lazy = false;
+        unsigned int threads = 0;
+        unsigned int inlining = 0;
+        size_t memo = 1024;
+    };
+
+    typedef chrono::steady_clock Clock;
+
+    long long Milliseconds(Clock::time_point start)
+    {
+        return chrono::duration_cast<chrono::milliseconds>(Clock::now() - start).count();
+    }
+
+    unsigned int Number(const string& text)
+    {
+        size_t end = 0;
+        unsigned long n = stoul(text, &end);
+        if (end != text.size()) throw invalid_argument("Number expected, found: " + text);
+        return (unsigned int)n;
+    }
+
+    string ReadFile(const string& path)
+    {
+        ifstream ifs(path, ios::in | ios::binary);
+        if (!ifs.is_open()) throw invalid_argument("Could not open file: " + path);
+
+        stringstream ss;
+        ss << ifs.rdbuf();
+        return ss.str();
+    }
+
+    void WriteFile(const string& path, const string& text)
+    {
+        ofstream ofs(path, ios::out | ios::binary | ios::trunc);
+        if (!ofs.is_open()) throw invalid_argument("Could not create file: " + path);
+
+        ofs << text;
+        cerr << "Written: " << path << " (" << text.size() / 1024 << " KB)" << endl;
+    }
+
+    // the options at args[i] and after, i is left at the first argument that is not an option
+    Options ParseOptions(const vector<string>& args, size_t& i)
+    {
+        Options options;
+
+        for (; i < args.size() && args[i].size() > 1 && args[i][0] == '-' && args[i] != "--"; i++)
+        {
+            const string& option = args[i];
+
+            if (option == "-lazy") { options.lazy = true; continue; }
+
+            if (i + 1 >= args.size()) throw invalid_argument("Value of " + option + " missing");
+            unsigned int value = Number(args[++i]);
+
+            if (option == "-threads")     options.threads = value;
+            else if (option == "-inline") options.inlining = value;
+            else if (option == "-memo")   options.memo = value;
+            else throw invalid_argument("Unknown option: " + option);
+        }
+        return options;
+    }
+
+    void Configure(ScriptInterpreter& si, const Options& options)
+    {
+        si.SetLazyParsing(options.lazy);
+        si.SetLoadThreads(options.threads);
+        si.SetInlining(options.inlining);
+        si.SetMemoization(options.memo);
+    }
+
+    int Load(const vector<string>& args, size_t i)
+    {
+        Options options = ParseOptions(args, i);
+        if (i + 2 > args.size()) throw invalid_argument("Usage: Bench load [options] <runs> <file>...");
+
+        unsigned int runs = Number(args[i++]);
+        StrVec files(args.begin() + i, args.end());
+
+        MockAdapter adapter(0);
+        long long best = -1;
+
+        for (unsigned int run = 0; run < runs; run++)
+        {
+            ScriptInterpreter si(&adapter);
+            Configure(si, options);
+
+            auto start = Clock::now();
+            si.Load(files);
+            long long ms = Milliseconds(start);
+
+            if (best < 0 || ms < best) best = ms;
+        }
+
+        cerr << "LOAD " << best << " ms (best of " << runs << ")" << endl;
+        return 0;
+    }
+
+    int Execute(const vector<string>& args, size_t i)
+    {
+        Options options = ParseOptions(args, i);
+        if (i + 4 > args.size()) throw invalid_argument("Usage: Bench execute [options] <bytecode|closures|tree> <nodes> <runs> <file>... [-- <function>...]");
+
+        const string engine = args[i++];
+        unsigned int nodes = Number(args[i++]);
+        unsigned int runs = Number(args[i++]);
+
+        StrVec files, functions;
+        for (bool isFile = true; i < args.size(); i++)
+        {
+            if (args[i] == "--") { isFile = false; continue; }
+            (isFile ? files : functions).push_back(args[i]);
+        }
+
+        MockAdapter adapter(nodes);
+        ScriptInterpreter si(&adapter);
+        Configure(si, options);
+
+        if (engine == "bytecode")      si.SetExecutionEngine(ExecutionEngine::BYTECODE);
+        else if (engine == "closures") si.SetExecutionEngine(ExecutionEngine::CLOSURES);
+        else if (engine == "tree")     si.SetExecutionEngine(ExecutionEngine::TREE_WALKER);
+        else throw invalid_argument("Unknown engine: " + engine);
+
+        si.Load(files);
+        if (functions.empty()) functions = si.GetLoadedFunctions();
+
+        auto start = Clock::now();
+        vector<bool> results;
+        for (unsigned int run = 0; run < runs; run++) results = si.Execute(functions);
+        long long ms = Milliseconds(start);
+
+        size_t passed = 0;
+        for (bool result : results) passed += result;
+
+        cerr << "EXECUTE " << engine << " " << ms << " ms (" << runs << " runs, " << nodes << " nodes, "
+             << passed << " of " << results.size() << " functions TRUE)" << endl;
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> args(argv + 1, argv + argc);
+
+    try
+    {
+        const string command = args.empty() ? "" : args[0];
+
+        if (command == "replicate" && args.size() == 4)
+        {
+            WriteFile(args[3], RuleGenerator::Replicate(ReadFile(args[1]), Number(args[2])));
+            return 0;
+        }
+        if (command == "nested" && args.size() == 4)
+        {
+            WriteFile(args[3], RuleGenerator::Nested(Number(args[1]), Number(args[2]), 1));
+            return 0;
+        }
+        if (command == "load")    return Load(args, 1);
+        if (command == "execute") return Execute(args, 1);
+
+        cerr << "Usage: Bench <replicate|nested|load|execute> ..., see bench\\main.cpp" << endl;
+        return 1;
+    }
+    catch (const exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,93 @@
+#include "mock_adapter.h"
+
+using namespace std;
+
+namespace
+{
+    const char* const NODE_TYPES[] = { "Zone", "Road", "Building" };
+}
+
+bool MockAttributes::Exists(string attributeName) const
+{
+    return node->attributes.count(attributeName) > 0;
+}
+
+string MockAttributes::GetValueOf(const string& attributeName) const
+{
+    auto it = node->attributes.find(attributeName);
+    return (it == node->attributes.end()) ? string() : it->second;
+}
+
+string MockAttributes::ToString() const
+{
+    string s = "{" + node->type;
+    for (auto& attribute : node->attributes)
+    {
+        s += " " + attribute.first + "=" + attribute.second;
+    }
+    return s + "}";
+}
+
+MockAdapter::MockAdapter(unsigned int count)
+{
+    for (unsigned int i = 0; i < count; i++)
+    {
+        auto node = make_unique<CSyntaxNode>();
+
+        node->type = NODE_TYPES[i % 3];
+        node->attributes["id"] = to_string(i);
+        node->attributes["name"] = (i % 2 ? "closed_" : "open_") + to_string(i % 7);
+        node->attributes["state"] = (i % 4 == 0) ? "closed" : "open";
+        if (i % 5 != 0) node->attributes["level"] = to_string(i % 11);
+        if (i > 0) node->parent = nodes[(i - 1) / 2].get();
+
+        nodes.push_back(move(node));
+    }
+
+    for (size_t i = 1; i + 1 < nodes.size(); i += 2)
+    {
+        nodes[i]->conditions.push_back(nodes[i + 1].get());
+    }
+}
+
+vector<CSyntaxNode*> MockAdapter::GetParentsForNode(CSyntaxNode* p) const
+{
+    vector<CSyntaxNode*> parents;
+    if (p && p->parent) parents.push_back(p->parent);
+    return parents;
+}
+
+vector<CSyntaxNode*> MockAdapter::GetAllNodesOfType(string nodeTypeName, CSyntaxNode*) const
+{
+    vector<CSyntaxNode*> result;
+    for (auto& node : nodes)
+    {
+        if (node->type == nodeTypeName) result.push_back(node.get());
+    }
+    return result;
+}
+
+vector<CSyntaxNode*> MockAdapter::GetGeogConds(CSyntaxNode* p) const
+{
+    return p ? p->conditions : vector<CSyntaxNode*>();
+}
+
+shared_ptr<IAttributes> MockAdapter::GetAttributesOf(CSyntaxNode* p) const
+{
+    if (!p) return nullptr;
+    return make_shared<MockAttributes>(p);
+}
+
+bool MockAdapter::Exists(string nodeType) const
+{
+    for (const char* type : NODE_TYPES)
+    {
+        if (nodeType == type) return true;
+    }
+    return false;
+}
+
+bool MockAdapter::Exists(unsigned int) const
+{
+    return true;
+}
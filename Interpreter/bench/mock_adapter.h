@@ -0,0 +1,48 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "adapter_interface.h"
+
+// Node graph of the benchmarks: 'count' nodes of the types Zone, Road and Building in a binary tree
+// (PARENT), every second node with the next one as its condition (CONDITIONS_OF). The attributes
+// id, name, state and level vary with the index; every fifth node has no level.
+class CSyntaxNode
+{
+public:
+    std::string type;
+    std::map<std::string, std::string> attributes;
+    CSyntaxNode* parent = nullptr;
+    std::vector<CSyntaxNode*> conditions;
+};
+
+class MockAttributes : public IAttributes
+{
+private:
+    const CSyntaxNode* node;
+
+public:
+    MockAttributes(const CSyntaxNode* n) : node(n) {}
+
+    bool Exists(std::string attributeName) const;
+    std::string GetValueOf(const std::string& attributeName) const;
+    std::string ToString() const;
+};
+
+class MockAdapter : public IAdapter
+{
+private:
+    std::vector<std::unique_ptr<CSyntaxNode>> nodes;
+
+public:
+    MockAdapter(unsigned int count);
+
+    std::vector<CSyntaxNode*> GetParentsForNode(CSyntaxNode* p) const;
+    std::vector<CSyntaxNode*> GetAllNodesOfType(std::string nodeTypeName, CSyntaxNode* root) const;
+    std::vector<CSyntaxNode*> GetGeogConds(CSyntaxNode* p) const;
+    std::shared_ptr<IAttributes> GetAttributesOf(CSyntaxNode* p) const;
+    bool Exists(std::string nodeType) const;
+    bool Exists(unsigned int nodeType) const;
+};
@@ -0,0 +1,136 @@
+#include "rule_generator.h"
+#include <functional>
+#include <random>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    bool IsNameChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    // names of the definitions, i.e. the lines starting with @Name: or @Name(
+    set<string> DefinedNames(const string& text)
+    {
+        set<string> names;
+        istringstream lines(text);
+        string line;
+
+        while (getline(lines, line))
+        {
+            if (line.empty() || line[0] != '@') continue;
+
+            size_t end = 1;
+            while (end < line.size() && IsNameChar(line[end])) end++;
+
+            if (end > 1 && end < line.size() && (line[end] == ':' || line[end] == '('))
+            {
+                names.insert(line.substr(1, end - 1));
+            }
+        }
+        return names;
+    }
+
+    const char* const LEAVES[] =
+    {
+        "#x.level > 3",
+        "#x.level <= 9",
+        "#x.state == \"closed\"",
+        "#x.name.StartsWith(\"open\")",
+        "#x.name.EndsWith(\"_3\")",
+        "#x.name.Contains(\"en_1\")",
+        "#x == NULL",
+        "TRUE"
+    };
+}
+
+string RuleGenerator::Replicate(const string& text, unsigned int copies)
+{
+    const set<string> names = DefinedNames(text);
+    string result;
+
+    for (unsigned int copy = 0; copy < copies; copy++)
+    {
+        const string suffix = "_" + to_string(copy);
+
+        // @Name and #Name (the result of the function inside its body) of a defined function get the suffix
+        size_t from = 0;
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            if ((text[i] != '@' && text[i] != '#') || (i > 0 && IsNameChar(text[i - 1]))) continue;
+
+            size_t end = i + 1;
+            while (end < text.size() && IsNameChar(text[end])) end++;
+
+            if (names.count(text.substr(i + 1, end - i - 1)))
+            {
+                result.append(text, from, end - from);
+                result += suffix;
+                from = end;
+            }
+            i = end - 1;
+        }
+        result.append(text, from, string::npos);
+
+        if (!result.empty() && result.back() != '\n') result += '\n';
+        result += '\n';
+    }
+    return result;
+}
+
+string RuleGenerator::Nested(unsigned int functions, unsigned int depth, unsigned int seed)
+{
+    mt19937 random(seed);
+    stringstream ss;
+
+    function<void(unsigned int)> condition = [&](unsigned int level)
+    {
+        if (level == 0)
+        {
+            ss << LEAVES[random() % (sizeof(LEAVES) / sizeof(LEAVES[0]))];
+            return;
+        }
+
+        switch (random() % 3)
+        {
+        case 0:
+            ss << "NOT(";
+            condition(level - 1);
+            ss << ")";
+            break;
+
+        default:
+            ss << "(";
+            condition(level - 1);
+            ss << (random() % 2 ? " AND " : " OR ");
+            condition(level - 1);
+            ss << ")";
+            break;
+        }
+    };
+
+    for (unsigned int i = 0; i < functions; i++)
+    {
+        ss << "@Nested_" << i << "(x):" << endl;
+        ss << "    @Nested_" << i << " = ";
+        condition(depth);
+        ss << endl << "END" << endl << endl;
+    }
+
+    // runs every function on every zone, so the generated file can be executed as well
+    ss << "@NestedAll:" << endl;
+    ss << "    @NestedAll = TRUE" << endl;
+    ss << "    FOR #z IN GET_NODES_OF_TYPE(Zone)" << endl;
+    for (unsigned int i = 0; i < functions; i++)
+    {
+        ss << "        #r" << i << " = @Nested_" << i << "(#z)" << endl;
+    }
+    ss << "    END" << endl;
+    ss << "END" << endl;
+
+    return ss.str();
+}
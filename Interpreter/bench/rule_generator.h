@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+// Rule files of the benchmarks
+namespace RuleGenerator {
+    // the rule text 'copies' times, the functions it defines renamed to Name_0, Name_1, ... in the copies.
+    // Calls of functions that the text does not define keep their names.
+    std::string Replicate(const std::string& text, unsigned int copies);
+
+    // 'functions' functions of one parameter each, whose result is a random tree of AND, OR and NOT
+    // of 'depth' levels over attribute checks. The same seed gives the same text.
+    std::string Nested(unsigned int functions, unsigned int depth, unsigned int seed);
+}
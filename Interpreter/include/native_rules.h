@@ -0,0 +1,216 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "adapter_interface.h"
+#include "node_value.h"
+
+// Rule sets compiled to native code
+// =================================
+// Interpreter::BuildNative writes a rule set as C++ source that includes this header, and compiles it
+// to a library exporting GetNativeRuleSet. The header is the whole contract between the interpreter
+// and the library: both have to be built with the same compiler, the library is ignored if its
+// NATIVE_RULES_VERSION differs. The helpers below produce the values and errors of the operations.
+
+#define NATIVE_RULES_VERSION 4
+
+#ifdef _WIN32
+#define NATIVE_RULES_EXPORT extern "C" __declspec(dllexport)
+#else
+#define NATIVE_RULES_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace NativeRules
+{
+    typedef NodeValue Value;                    // VarValue of the interpreter
+
+    struct Host                                 // services of the interpreter running the library
+    {
+        IAdapter* adapter;
+        std::pmr::memory_resource* memory;      // of the node sets of the execution
+        void (*print)(const std::string& text); // PRINTS and PRINT
+        void (*printLine)();                    // PRINTS("endl")
+        void (*error)(const std::string& message);  // a runtime error handled by a function call
+    };
+
+    struct RuleSet
+    {
+        unsigned int version;                   // NATIVE_RULES_VERSION
+        unsigned int fileCount;
+        const uint64_t* fileHashes;             // hashes of the loaded rule files the library was built from, in load order
+        unsigned int functionCount;
+        const char* const* functions;           // names, sorted
+        // runs a function without parameters, false if it ended with a runtime error (in 'error')
+        bool (*execute)(const Host& host, unsigned int function, bool& result, std::string& error);
+    };
+
+    typedef const RuleSet* (*GetRuleSetFn)();
+
+    struct Error                                // RuntimeError of the generated code, thrown
+    {
+        std::string message;
+    };
+
+    struct Var                                  // a variable of a function, defined or not
+    {
+        bool defined = false;
+        Value value;
+    };
+
+    enum Check { EQUAL, STARTS_WITH, ENDS_WITH, CONTAINS, LT, GT, LE, GE };    // CheckType
+
+    inline Value True()
+    {
+        return Value::True();                   // non empty value means true
+    }
+
+    inline std::string At(const char* text, int line)
+    {
+        return std::string(text) + std::to_string(line);
+    }
+
+    inline const Value& Get(const Var& var, const char* name, int line)
+    {
+        if (!var.defined) throw Error{ "Undefined variable: " + std::string(name) + At(" @line: ", line) };
+        return var.value;
+    }
+
+    inline bool IsNumber(const std::string& str)
+    {
+        if (str.empty()) return false;
+        for (char c : str) if (c < '0' || c > '9') return false;
+        return true;
+    }
+
+    inline void Print(const Host& host, const Value& nodes)
+    {
+        for (auto node : nodes)
+        {
+            auto attribs = host.adapter->GetAttributesOf(node);
+            if (attribs) host.print(attribs->ToString());
+        }
+    }
+
+    inline Value ConditionsOf(const Host& host, const Value& val, const char* tok, int line)
+    {
+        if (val.empty()) throw Error{ std::string(tok) + At(" called with expression which returned nothing. @Line: ", line) };
+        if (0 == val[0]) throw Error{ "Operation " + std::string(tok) + At(" parameter is NULL pointer. @Line: ", line) };
+
+        return Value(host.adapter->GetGeogConds(val[0]), host.memory);
+    }
+
+    inline Value Parent(const Host& host, const Value& val)
+    {
+        return val.empty() ? Value() : Value(host.adapter->GetParentsForNode(val[0]), host.memory);
+    }
+
+    inline Value NodesOfType(const Host& host, const std::string& type, const char* tok, int line)
+    {
+        if (!host.adapter->Exists(type))
+        {
+            throw Error{ "Parameter \"" + type + "\" of " + tok + At(" is not a known Node Type. @Line: ", line) };
+        }
+        return Value(host.adapter->GetAllNodesOfType(type, 0), host.memory);
+    }
+
+    inline Value CheckAttribute(const Host& host, const Var& var, const char* name, const std::string& attribute,
+                                std::string_view value, Check check, int line)
+    {
+        const Value& val = Get(var, name, line);
+
+        if (val.empty()) throw Error{ "Variable named \"" + std::string(name) + At("\" has empty value! @Line: ", line) };
+
+        ATTR_PTR attributes = host.adapter->GetAttributesOf(val[0]);
+
+        if (!attributes) throw Error{ "Variable named \"" + std::string(name) + At("\" has no attributes! @Line: ", line) };
+        if (!attributes->Exists(attribute))
+        {
+            throw Error{ "Variable named \"" + std::string(name) + "\" has no attribute named \"" + attribute + At("\" ! @Line: ", line) };
+        }
+
+        std::string current = attributes->GetValueOf(attribute);
+
+        auto number = [&](const std::string& text)
+        {
+            try
+            {
+                return std::stoi(text);
+            }
+            catch (std::invalid_argument&)
+            {
+                throw Error{ "Cannot compare value of " + std::string(name) + "." + attribute + ":" + text + At(" with a number! @Line: ", line) };
+            }
+        };
+
+        bool result = false;
+        switch (check)
+        {
+        case EQUAL:         result = current == value; break;
+        case STARTS_WITH:   result = current.compare(0, value.length(), value) == 0; break;
+        case ENDS_WITH:     result = current.length() >= value.length() && current.substr(current.length() - value.length()) == value; break;
+        case CONTAINS:      result = current.find(value) != std::string::npos; break;
+        case LT:            result = number(current) < std::stoi(std::string(value)); break;
+        case GT:            result = number(current) > std::stoi(std::string(value)); break;
+        case LE:            result = number(current) <= std::stoi(std::string(value)); break;
+        case GE:            result = number(current) >= std::stoi(std::string(value)); break;
+        }
+
+        return result ? True() : Value();
+    }
+
+    inline Value CompareAttributes(const Host& host,
+                                   const Var& var1, const char* name1, const std::string& attribute1, std::string_view prefix1, std::string_view postfix1,
+                                   const Var& var2, const char* name2, const std::string& attribute2, std::string_view prefix2, std::string_view postfix2,
+                                   Check check, int line)
+    {
+        if (!var1.defined) throw Error{ "Unknown variable " + std::string(name1) + At(" @Line:", line) };
+        if (!var2.defined) throw Error{ "Unknown variable " + std::string(name2) + At(" @Line:", line) };
+
+        if (var1.value.size() != 1) throw Error{ "Variable \"" + std::string(name1) + At("\" has no value! @Line: ", line) };
+        if (var2.value.size() != 1) throw Error{ "Variable \"" + std::string(name2) + At("\" has no value! @Line: ", line) };
+
+        ATTR_PTR attributes1 = host.adapter->GetAttributesOf(var1.value[0]);
+        ATTR_PTR attributes2 = host.adapter->GetAttributesOf(var2.value[0]);
+
+        if (!attributes1) throw Error{ "Variable named \"" + std::string(name1) + At("\" has no attributes! @Line: ", line) };
+        if (!attributes2) throw Error{ "Variable named \"" + std::string(name2) + At("\" has no attributes! @Line: ", line) };
+
+        if (!attributes1->Exists(attribute1))
+        {
+            throw Error{ "Variable named \"" + std::string(name1) + "\" has no attribute named \"" + attribute1 + At("\" ! @Line: ", line) };
+        }
+        if (!attributes2->Exists(attribute2))
+        {
+            throw Error{ "Variable named \"" + std::string(name2) + "\" has no attribute named \"" + attribute2 + At("\" ! @Line: ", line) };
+        }
+
+        std::string val1 = std::string(prefix1) + attributes1->GetValueOf(attribute1) + std::string(postfix1);
+        std::string val2 = std::string(prefix2) + attributes2->GetValueOf(attribute2) + std::string(postfix2);
+
+        auto number = [&](const std::string& text, const char* name, const std::string& attribute)
+        {
+            if (!IsNumber(text))
+            {
+                throw Error{ "Value of " + std::string(name) + "." + attribute + " \"" + text + At("\" is not a number! @Line: ", line) };
+            }
+            return std::stoi(text);
+        };
+
+        bool result = false;
+        switch (check)
+        {
+        case EQUAL: result = val1 == val2; break;
+        case LT:    result = number(val1, name1, attribute1) < number(val2, name2, attribute2); break;
+        case GT:    result = number(val1, name1, attribute1) > number(val2, name2, attribute2); break;
+        case LE:    result = number(val1, name1, attribute1) <= number(val2, name2, attribute2); break;
+        case GE:    result = number(val1, name1, attribute1) >= number(val2, name2, attribute2); break;
+        default:    break;
+        }
+
+        return result ? True() : Value();
+    }
+}
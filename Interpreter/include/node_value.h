@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+class CSyntaxNode;
+
+// Value of an expression
+// ======================
+// A sequence of nodes, true when it is not empty: FALSE and NULL are the empty value, TRUE is one
+// null node. Empty and single node values, so every boolean and every FOR variable, are kept inline.
+// Sets of two nodes or more are kept on the heap, immutable and shared by reference count: assigning,
+// returning or passing a set to a function copies a pointer. There is no way to change the nodes of
+// a value, a value only gets replaced; an operation changing a set in place would have to copy the
+// set first if it is shared. During an execution the sets are allocated from its arena
+// (execution_memory.h), a value must not outlive the execution.
+class NodeValue
+{
+private:
+    typedef std::vector<CSyntaxNode*> NodeSet;
+    typedef std::shared_ptr<const NodeSet> SharedSet;
+
+    enum Kind : unsigned char { NONE, ONE, SET };
+
+    Kind kind;
+    union
+    {
+        CSyntaxNode* node;
+        SharedSet nodes;
+    };
+
+public:
+    NodeValue() noexcept : kind(NONE), node(nullptr) {}
+    explicit NodeValue(CSyntaxNode* one) noexcept : kind(ONE), node(one) {}
+
+    NodeValue(NodeSet set)          // the node lists of the adapter
+        : kind(NONE), node(nullptr)
+    {
+        Assign(std::move(set), std::allocator<NodeSet>());
+    }
+
+    NodeValue(NodeSet set, std::pmr::memory_resource* memory)   // a set is shared from the memory of the execution
+        : kind(NONE), node(nullptr)
+    {
+        Assign(std::move(set), std::pmr::polymorphic_allocator<NodeSet>(memory));
+    }
+
+    NodeValue(const NodeValue& other) : kind(NONE), node(nullptr) { Copy(other); }
+    NodeValue(NodeValue&& other) noexcept : kind(NONE), node(nullptr) { Take(other); }
+
+    NodeValue& operator=(const NodeValue& other)
+    {
+        if (this != &other)
+        {
+            clear();
+            Copy(other);
+        }
+        return *this;
+    }
+
+    NodeValue& operator=(NodeValue&& other) noexcept
+    {
+        if (this != &other)
+        {
+            clear();
+            Take(other);
+        }
+        return *this;
+    }
+
+    ~NodeValue() { clear(); }
+
+    static NodeValue True() noexcept { return NodeValue(static_cast<CSyntaxNode*>(nullptr)); }
+
+    bool empty() const noexcept { return kind == NONE; }
+    size_t size() const noexcept { return kind == SET ? nodes->size() : (kind == ONE ? 1 : 0); }
+
+    CSyntaxNode* const* begin() const noexcept { return kind == SET ? nodes->data() : &node; }
+    CSyntaxNode* const* end() const noexcept { return begin() + size(); }
+    CSyntaxNode* operator[](size_t i) const noexcept { return begin()[i]; }
+
+    void clear() noexcept
+    {
+        if (kind == SET) nodes.~SharedSet();
+        kind = NONE;
+        node = nullptr;
+    }
+
+private:
+    template<class Allocator>
+    void Assign(NodeSet set, const Allocator& allocator)    // into an empty value
+    {
+        if (set.size() == 1)
+        {
+            kind = ONE;
+            node = set[0];
+        }
+        else if (set.size() > 1)
+        {
+            new (&nodes) SharedSet(std::allocate_shared<NodeSet>(allocator, std::move(set)));
+            kind = SET;
+        }
+    }
+
+    void Copy(const NodeValue& other)   // into an empty value
+    {
+        if (other.kind == SET) new (&nodes) SharedSet(other.nodes);   // shares the set
+        else node = other.node;
+        kind = other.kind;
+    }
+
+    void Take(NodeValue& other) noexcept    // into an empty value, the other one is left empty
+    {
+        if (other.kind == SET) new (&nodes) SharedSet(std::move(other.nodes));
+        else node = other.node;
+        kind = other.kind;
+        other.clear();
+    }
+};
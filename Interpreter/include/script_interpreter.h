@@ -4,6 +4,7 @@
 #include <vector>
 #include "adapter_interface.h"
 #include "..\src\interpreter.h"
+#include "..\src\incremental_parser.h"
 
 typedef std::vector<std::string> StrVec;
 
@@ -14,7 +15,46 @@ public:
     ScriptInterpreter(IAdapter * const adapter);
 
     void Load(StrVec filePaths);
+    void Reload(StrVec filePaths);              // parses only the files that changed since the last Load/Reload
+    void SetLoadThreads(unsigned int count); // files (and parts of large files) parsed in parallel by Load, 0 = one per hardware thread
+    void SetRuleCache(bool enabled, std::string directory = ""); // Load keeps compiled images of the rule files, next to them if directory is empty
+    void LoadBundle(std::string bundlePath);    // loads the rule set of SaveBundle, the rule files are not needed
+    void SaveBundle(std::string bundlePath);    // writes the rule files of the last load as one compiled image
+    void SetLazyParsing(bool enabled);          // Load only scans function headers, bodies are parsed when first executed
+    StrVec Validate();                          // parses all bodies not parsed yet and returns the parse errors
+    void WatchRuleFiles(bool enabled);          // reloads changed rule files in the background, Execute keeps the functions it started with
+    void SetExecutionEngine(ExecutionEngine engine);    // BYTECODE by default, CLOSURES or TREE_WALKER to compare
+    void SetInlining(unsigned int instructions);    // Load writes bodies of up to this many bytecode instructions into their callers, at the cost of compiling every body; 0 = off (default)
+    void SetExecutionMemory(size_t initialSize);    // bytes Execute allocates its values from before it uses the heap, 64 KB by default
+    ExecutionMemoryStats GetExecutionMemoryStats(); // of the last Execute, 'largest' is the initial size that would have been enough
+    void SetMemoization(size_t entries);        // results of pure functions Execute keeps, by function and argument nodes; 1024 by default, 0 = off
+    MemoStats GetMemoizationStats();            // hits and misses of the last Execute
+    void SetNativeCompiler(std::string command, std::string includeDirectory);  // for BuildNative: {source} {library} {include} are replaced by quoted paths,
+                                                                                // includeDirectory holds native_rules.h; "" = MSVC cl, from a developer prompt
+    void BuildNative(std::string libraryPath);  // writes the loaded functions as C++ next to the library and compiles them, after SetNativeCompiler
+    void LoadNative(std::string libraryPath);   // Execute runs native functions while the loaded rule files match the library, else interprets
     StrVec GetLoadedFunctions();
 
     std::vector<bool> Execute(StrVec functions);
+};
+
+struct RuleFunction
+{
+    std::string name;
+    StrVec parameters;
+    int line;                                   // of the name
+};
+
+// A rule file open in an editor: an edit re-parses only the definitions it touches, so the functions
+// and parse errors can be shown while the user types. The file is not loaded into any interpreter.
+class RuleEditor
+{
+    IncrementalParser parser;
+public:
+    RuleEditor(std::string filePath, std::string text);
+
+    void Edit(unsigned int begin, unsigned int end, std::string replacement);  // replaces the characters [begin, end) of the text
+    std::string GetText();
+    std::vector<RuleFunction> GetFunctions();   // in the order of the text
+    StrVec GetErrors();                         // the parse errors, bodies included
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "arena.h"
+#include <algorithm>
+
+using namespace std;
+
+// small bodies are common, the blocks grow with the body up to the largest size
+static const size_t FIRST_BLOCK = 256;
+static const size_t LARGEST_BLOCK = 16 * 1024;
+
+
+
+void* OperationArena::Region::Allocate(size_t size, size_t alignment)
+{
+    if (!blocks.empty())
+    {
+        Block& block = blocks.back();
+        size_t offset = (block.used + alignment - 1) & ~(alignment - 1);
+
+        if (offset + size <= block.size)
+        {
+            block.used = offset + size;
+            return block.memory.get() + offset;
+        }
+    }
+
+    size_t blockSize = blocks.empty() ? FIRST_BLOCK : min(blocks.back().size * 2, LARGEST_BLOCK);
+    blockSize = max(blockSize, size);
+
+    blocks.push_back({ unique_ptr<char[]>(new char[blockSize]), blockSize, size });   // new[] aligns for any type
+    return blocks.back().memory.get();
+}
+
+
+
+OperationArena::~OperationArena()
+{
+    for (auto it = destructors.rbegin(); it != destructors.rend(); ++it)
+    {
+        it->destroy(it->object);
+    }
+}
+
+OpList OperationArena::List(const vector<OP_PTR>& ops)
+{
+    if (ops.empty()) return OpList();
+
+    OP_PTR* items = static_cast<OP_PTR*>(memory.Allocate(ops.size() * sizeof(OP_PTR), alignof(OP_PTR)));
+    copy(ops.begin(), ops.end(), items);
+
+    return OpList(items, (uint32_t)ops.size());
+}
+
+const TokenInfo& OperationArena::Locate(const TokenInfo& location)
+{
+    return *new (locations.Allocate(sizeof(TokenInfo), alignof(TokenInfo))) TokenInfo(location);
+}
+
+void OperationArena::ShiftLines(int delta)
+{
+    locations.ForEach<TokenInfo>([delta](TokenInfo& location) { location.line += delta; });
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "operation.h"
+#include "token.h"
+
+// Storage of a function body
+// ==========================
+// The operations of a function are allocated one after the other in the blocks of its arena, in
+// the order the parser completes them: the children of an operation before the operation, the way
+// they are evaluated. Child lists are in the same blocks; source locations are in blocks of their
+// own, so their lines can be moved when lines above the function are added or removed (incremental_parser.h).
+// Most bodies fit in the first block or two, so a function costs a few allocations instead of one
+// per operation. Everything is freed at once with the function.
+class OperationArena
+{
+private:
+    class Region
+    {
+    private:
+        struct Block
+        {
+            std::unique_ptr<char[]> memory;
+            size_t size;
+            size_t used;
+        };
+
+        std::vector<Block> blocks;
+
+    public:
+        void* Allocate(size_t size, size_t alignment);
+
+        // of a region that holds objects of type T only, in the order they were allocated
+        template<class T, class F>
+        void ForEach(F visit)
+        {
+            for (auto& block : blocks)
+            {
+                for (size_t offset = 0; offset + sizeof(T) <= block.used; offset += sizeof(T))
+                {
+                    visit(*reinterpret_cast<T*>(block.memory.get() + offset));
+                }
+            }
+        }
+    };
+
+    struct Destructor
+    {
+        void* object;
+        void (*destroy)(void* object);
+    };
+
+    Region memory;
+    Region locations;                       // TokenInfo only
+    std::vector<Destructor> destructors;    // of the objects that need one, run in reverse order
+
+public:
+    OperationArena() = default;
+    ~OperationArena();
+    OperationArena(const OperationArena&) = delete;
+    OperationArena& operator=(const OperationArena&) = delete;
+
+    template<class T, class... Args>
+    T* New(Args&&... args)
+    {
+        T* object = new (memory.Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if (!std::is_trivially_destructible<T>::value)
+        {
+            destructors.push_back({ object, [](void* p) { static_cast<T*>(p)->~T(); } });
+        }
+        return object;
+    }
+
+    OpList List(const std::vector<OP_PTR>& ops);        // copies a child list to the arena
+    const TokenInfo& Locate(const TokenInfo& location); // copies a source location to the arena
+    void ShiftLines(int delta);                         // of all source locations
+};
@@ -0,0 +1,395 @@
+#include "bytecode.h"
+#include "operations.h"
+#include "function_table.h"
+#include "operation_exceptions.h"
+#include "trace.h"
+#include <algorithm>
+
+using namespace std;
+
+
+
+BytecodeWriter::BytecodeWriter(Bytecode& code)
+    : out(code), depth(0), table(nullptr), frame(nullptr), base(0), inlined(0)
+{
+}
+
+BytecodeWriter::BytecodeWriter(Bytecode& code, const FunctionTable& functions, FrameLayout& layout)
+    : out(code), depth(0), table(&functions), frame(&layout), base(0), inlined(0)
+{
+}
+
+uint32_t BytecodeWriter::Emit(OpCode op, const TokenInfo& t, uint32_t a, uint32_t b)
+{
+    switch (op)     // effect of the instruction on the stack
+    {
+    case OpCode::PUSH_TRUE:
+    case OpCode::PUSH_FALSE:
+    case OpCode::LOAD_VAR:
+    case OpCode::LOAD_SLOT:
+    case OpCode::NULL_CHECK:
+    case OpCode::NULL_CHECK_SLOT:
+    case OpCode::GET_NODES:
+    case OpCode::ATTR_CHECK:
+    case OpCode::COMPARE_ATTR:
+        depth++;
+        break;
+    case OpCode::STORE_VAR:
+    case OpCode::POP:
+    case OpCode::JUMP_IF_FALSE:
+    case OpCode::FOR_BEGIN:
+    case OpCode::PRINT:
+        depth--;
+        break;
+    case OpCode::ALL:
+    case OpCode::ANY:
+        depth -= (int)a - 1;
+        break;
+    case OpCode::CALL:
+        depth -= (int)b - 1;
+        break;
+    default:
+        break;
+    }
+
+    if (depth < 0) { throw OperationBugException(BUG_LOCATION); }
+
+    switch (op)     // slots of the body being written, an inlined body has its slots after those of its caller
+    {
+    case OpCode::LOAD_VAR:
+    case OpCode::LOAD_SLOT:
+    case OpCode::NULL_CHECK:
+    case OpCode::NULL_CHECK_SLOT:
+    case OpCode::STORE_VAR:
+    case OpCode::FOR_NEXT:
+    case OpCode::FOR_END:
+    case OpCode::CLEAR:
+        a += base;
+        break;
+    case OpCode::ATTR_CHECK:
+    case OpCode::COMPARE_ATTR:
+        b = base;
+        break;
+    default:
+        break;
+    }
+
+    out.code.push_back({ op, a, b });
+    out.tokens.push_back(t);
+
+    return (uint32_t)out.code.size() - 1;
+}
+
+uint32_t BytecodeWriter::Here() const
+{
+    return (uint32_t)out.code.size();
+}
+
+void BytecodeWriter::Patch(uint32_t at)
+{
+    out.code[at].b = Here();
+}
+
+uint32_t BytecodeWriter::String(const string& s)
+{
+    out.strings.push_back(s);
+    return (uint32_t)out.strings.size() - 1;
+}
+
+uint32_t BytecodeWriter::Node(const Operation* op)
+{
+    out.operations.push_back(op);
+    return (uint32_t)out.operations.size() - 1;
+}
+
+const Function* BytecodeWriter::Inlined(SymbolId function, size_t arguments) const
+{
+    if (!table || !table->Inlined(function)) return nullptr;
+
+    const Function* callee = table->Callee(function);
+    return arguments == callee->getParams().size() ? callee : nullptr;     // a wrong call fails at run time, as a call
+}
+
+uint32_t BytecodeWriter::Enter(const FrameLayout& callee, const TokenInfo& t)
+{
+    uint32_t caller = base;
+    base = (uint32_t)frame->names.size();
+
+    frame->names.insert(frame->names.end(), callee.names.begin(), callee.names.end());
+    inlined++;
+
+    // a body inlined in a loop finds the values of the round before in its slots, only the
+    // parameters and the return value are set when it starts
+    vector<char> set(callee.names.size(), 0);
+    for (auto slot : callee.params) set[slot] = 1;
+    set[callee.result] = 1;
+
+    if (find(set.begin(), set.end(), 0) != set.end())
+    {
+        Emit(OpCode::CLEAR, t, 0, (uint32_t)callee.names.size());
+    }
+
+    return caller;
+}
+
+void BytecodeWriter::Leave(uint32_t caller)
+{
+    base = caller;
+}
+
+void BytecodeWriter::Expression(const OP_PTR& op)
+{
+    if (!op) { throw OperationBugException(BUG_LOCATION); }
+
+    int before = depth;
+    op->Compile(*this);
+
+    if (depth != before + 1) { throw OperationBugException(BUG_LOCATION); }
+}
+
+void BytecodeWriter::Statements(const OpList& ops)
+{
+    for (auto& op : ops)
+    {
+        if (!op) { throw OperationBugException(BUG_LOCATION); }
+
+        int before = depth;
+        op->Compile(*this);
+
+        while (depth > before)
+        {
+            Emit(OpCode::POP, op->t); // a function call used as a statement
+        }
+    }
+}
+
+
+
+const Bytecode& Function::Compiled() const
+{
+    if (!compiled.load(memory_order_acquire))
+    {
+        if (Parse()) { throw OperationBugException(BUG_LOCATION); }    // the caller checks the parse error
+
+        lock_guard<mutex> lock(parseMutex);
+
+        if (!compiled.load(memory_order_relaxed))
+        {
+            _TRACE_("        COMPILING: " << getId() << endl);
+
+            BytecodeWriter out(bytecode);
+            Compile(out);
+            compiled.store(true, memory_order_release);
+        }
+    }
+
+    return bytecode;
+}
+
+
+
+// Operation::Compile, the instructions of vm.cpp have the semantics of Operation::Exec
+
+void Function::Compile(BytecodeWriter & out) const
+{
+    out.Statements(operations);
+    out.Emit(OpCode::RETURN, t);
+}
+
+// the body written at a call site, the arguments are on the stack; a body has no RETURN before its end
+void Function::Inline(BytecodeWriter & out, const TokenInfo & call) const
+{
+    uint32_t caller = out.Enter(frame, call);
+
+    for (size_t i = parameters.size(); i-- > 0; )
+    {
+        // the last of the parameters with the same name is the one set, as in a call
+        bool shadowed = find(frame.params.begin() + i + 1, frame.params.end(), frame.params[i]) != frame.params.end();
+
+        if (shadowed) out.Emit(OpCode::POP, call);
+        else          out.Emit(OpCode::STORE_VAR, call, frame.params[i]);
+    }
+
+    out.Emit(OpCode::PUSH_FALSE, call);
+    out.Emit(OpCode::STORE_VAR, call, frame.result);
+
+    out.Statements(operations);
+    out.Emit(OpCode::LOAD_SLOT, call, frame.result);
+
+    out.Leave(caller);
+}
+
+void FunctionCall::Compile(BytecodeWriter & out) const
+{
+    if (const Function* callee = out.Inlined(id, parameters.size()))
+    {
+        uint32_t begin = out.Emit(OpCode::INLINE_BEGIN, t, id);
+
+        for (auto& param : parameters)
+        {
+            out.Expression(param);
+        }
+
+        callee->Inline(out, t);
+        out.Emit(OpCode::INLINE_END, t);
+        out.Patch(begin);
+        return;
+    }
+
+    uint32_t begin = out.Emit(OpCode::CALL_BEGIN, t, id);
+
+    for (auto& param : parameters)
+    {
+        out.Expression(param);
+    }
+
+    out.Patch(begin);
+    out.Emit(OpCode::CALL, t, id, (uint32_t)parameters.size());
+}
+
+void SetFunctionValue::Compile(BytecodeWriter & out) const
+{
+    out.Expression(op);
+    out.Emit(OpCode::STORE_VAR, t, slot);
+}
+
+void ConditionalBlock::Compile(BytecodeWriter & out) const
+{
+    // every block is evaluated, like in Exec, a block can call functions that print
+    if (sBlocks.size() == 1)
+    {
+        out.Expression(sBlocks[0]);
+    }
+    else if (pBlocks.size() == 1)
+    {
+        out.Expression(pBlocks[0]);
+    }
+    else if (sBlocks.size() > 1)
+    {
+        for (auto& block : sBlocks) out.Expression(block);
+        out.Emit(OpCode::ALL, t, (uint32_t)sBlocks.size());
+    }
+    else if (pBlocks.size() > 1)
+    {
+        for (auto& block : pBlocks) out.Expression(block);
+        out.Emit(OpCode::ANY, t, (uint32_t)pBlocks.size());
+    }
+    else { throw OperationBugException(BUG_LOCATION); }
+}
+
+void IfStmt::Compile(BytecodeWriter & out) const
+{
+    out.Expression(condition);
+    uint32_t toElse = out.Emit(OpCode::JUMP_IF_FALSE, t);
+
+    out.Statements(thanOperations);
+
+    if (elseOperations.empty())
+    {
+        out.Patch(toElse);
+    }
+    else
+    {
+        uint32_t toEnd = out.Emit(OpCode::JUMP, t);
+        out.Patch(toElse);
+        out.Statements(elseOperations);
+        out.Patch(toEnd);
+    }
+}
+
+void WhileLoop::Compile(BytecodeWriter & out) const
+{
+    uint32_t begin = out.Here();
+
+    out.Expression(condition);
+    uint32_t toEnd = out.Emit(OpCode::JUMP_IF_FALSE, t);
+
+    out.Statements(operations);
+    out.Emit(OpCode::JUMP, t, 0, begin);
+
+    out.Patch(toEnd);
+}
+
+void ForLoop::Compile(BytecodeWriter & out) const
+{
+    out.Expression(dataGetter);
+    out.Emit(OpCode::FOR_BEGIN, t);
+
+    uint32_t next = out.Emit(OpCode::FOR_NEXT, t, slot);
+    out.Statements(operations);
+    out.Emit(OpCode::FOR_END, t, slot, next);
+
+    out.Patch(next);
+}
+
+void Variable::Compile(BytecodeWriter & out) const
+{
+    if (proven) out.Emit(OpCode::LOAD_SLOT, t, slot);
+    else        out.Emit(OpCode::LOAD_VAR, t, slot, id);
+}
+
+void VariableAssignment::Compile(BytecodeWriter & out) const
+{
+    out.Expression(valueGetter);
+    out.Emit(OpCode::STORE_VAR, t, slot);
+}
+
+void NOT::Compile(BytecodeWriter & out) const
+{
+    out.Expression(expression);
+    out.Emit(OpCode::NOT, t);
+}
+
+void TRUE_VAL::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::PUSH_TRUE, t);
+}
+
+void FALSE_VAL::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::PUSH_FALSE, t);
+}
+
+void NullCheck::Compile(BytecodeWriter & out) const
+{
+    if (proven) out.Emit(OpCode::NULL_CHECK_SLOT, t, slot);
+    else        out.Emit(OpCode::NULL_CHECK, t, slot, varId);
+}
+
+void PRINTS::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::PRINTS, t, out.String(msg));
+}
+
+void PRINT::Compile(BytecodeWriter & out) const
+{
+    out.Expression(operation);
+    out.Emit(OpCode::PRINT, t);
+}
+
+void CONDITIONS_OF::Compile(BytecodeWriter & out) const
+{
+    out.Expression(operation);
+    out.Emit(OpCode::CONDITIONS_OF, t);
+}
+
+void PARENT::Compile(BytecodeWriter & out) const
+{
+    out.Expression(operation);
+    out.Emit(OpCode::PARENT, t);
+}
+
+void GET_NODES_OF_TYPE::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::GET_NODES, t, out.String(typeName));
+}
+
+void AttributeCheck::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::ATTR_CHECK, t, out.Node(this));
+}
+
+void CompareAttribute::Compile(BytecodeWriter & out) const
+{
+    out.Emit(OpCode::COMPARE_ATTR, t, out.Node(this));
+}
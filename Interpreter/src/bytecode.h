@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "operation.h"
+#include "symbols.h"
+#include "token.h"
+
+class Function;
+class FunctionTable;
+struct FrameLayout;
+
+// Compiled function bodies
+// ========================
+// A function is compiled once, on its first call by the bytecode engine, into a flat array of
+// instructions for the stack machine of vm.cpp. Operands are resolved at compile time: variables
+// are frame slots (frames.h), texts are indexes in the string table, control flow is explicit jumps.
+// Attribute checks keep evaluating on their operation, they have no sub-expressions.
+//
+// A function table may also compile a function with the bodies of its small callees written into
+// its code (function_table.h). The slots of an inlined body follow those of its caller in the frame,
+// the writer adds the first of them to the slot operands. The instructions of the body keep the
+// tokens of the callee, so its runtime errors report the lines of its own source.
+enum class OpCode : uint8_t
+{
+    PUSH_TRUE,
+    PUSH_FALSE,
+    LOAD_VAR,       // a = slot, b = variable, checked for "Undefined variable"
+    LOAD_SLOT,      // a = slot, defined on every path to the instruction
+    NULL_CHECK,     // a = slot, b = variable, checked for "Undefined variable"
+    NULL_CHECK_SLOT,    // a = slot, defined on every path to the instruction
+    STORE_VAR,      // a = slot, pops the value
+    POP,
+    NOT,
+    ALL,            // a = values popped, pushes TRUE if all of them are non empty
+    ANY,            // a = values popped, pushes TRUE if one of them is non empty
+    JUMP,           // b = target
+    JUMP_IF_FALSE,  // b = target, pops the condition
+    FOR_BEGIN,      // pops the data set of the loop
+    FOR_NEXT,       // a = slot of the loop variable, b = target after the loop
+    FOR_END,        // a = slot of the loop variable, b = target of FOR_NEXT
+    CALL_BEGIN,     // a = function, b = position of the CALL; errors up to the CALL are handled by the call
+    CALL,           // a = function, b = parameters popped, pushes the return value
+    INLINE_BEGIN,   // a = function, b = position after the INLINE_END; errors up to it are handled like those of a call
+    INLINE_END,
+    CLEAR,          // a = first slot, b = slots undefined
+    PRINTS,         // a = string
+    PRINT,          // pops the nodes
+    CONDITIONS_OF,
+    PARENT,
+    GET_NODES,      // a = string (node type)
+    ATTR_CHECK,     // a = operation (AttributeCheck)
+    COMPARE_ATTR,   // a = operation (CompareAttribute)
+    RETURN,
+};
+
+struct Instruction
+{
+    OpCode op;
+    uint32_t a;
+    uint32_t b;
+};
+
+struct Bytecode
+{
+    std::vector<Instruction> code;
+    std::vector<TokenInfo> tokens;              // source token of every instruction, for runtime errors
+    std::vector<std::string> strings;
+    std::vector<const Operation*> operations;   // owned by the function the code was compiled from, or by an inlined callee
+};
+
+class BytecodeWriter
+{
+private:
+    Bytecode& out;
+    int depth;      // values on the stack of the machine at the end of the code written so far
+    const FunctionTable* table;     // of the inlined callees, null if every call stays a call
+    FrameLayout* frame;             // of the code, grows by the slots of the inlined bodies
+    uint32_t base;                  // first slot of the body being written
+    size_t inlined;                 // calls written as bodies
+
+public:
+    BytecodeWriter(Bytecode& code);
+    BytecodeWriter(Bytecode& code, const FunctionTable& table, FrameLayout& frame);     // inlines the functions the table allows
+
+    uint32_t Emit(OpCode op, const TokenInfo& t, uint32_t a = 0, uint32_t b = 0);   // returns the position of the instruction
+    uint32_t Here() const;
+    void Patch(uint32_t at);                    // the jump at 'at' goes to Here()
+    uint32_t String(const std::string& s);
+    uint32_t Node(const Operation* op);
+
+    const Function* Inlined(SymbolId function, size_t arguments) const;     // the callee to write at a call site, null for a call
+    uint32_t Enter(const FrameLayout& callee, const TokenInfo& t);     // slots of an inlined body, returns the base to Leave with
+    void Leave(uint32_t caller);
+    size_t Inlines() const { return inlined; }
+
+    void Expression(const OP_PTR& op);          // leaves exactly one value on the stack
+    void Statements(const OpList& ops);    // leaves none, the values of calls are dropped
+};
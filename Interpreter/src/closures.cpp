@@ -0,0 +1,493 @@
+#include "closures.h"
+#include "interpreter.h"
+#include "operations.h"
+#include "operation_exceptions.h"
+#include "trace.h"
+#include "utils.h"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    const VarValue TRUE_VALUE = VarValue::True();  // non empty value means true
+
+    Closure BindOne(const OP_PTR& op)
+    {
+        if (!op) { throw OperationBugException(BUG_LOCATION); }
+        return op->Bind();
+    }
+
+    vector<Closure> BindAll(const OpList& ops)
+    {
+        vector<Closure> closures;
+        closures.reserve(ops.size());
+
+        for (auto& op : ops)
+        {
+            closures.push_back(BindOne(op));
+        }
+        return closures;
+    }
+
+    RuntimeError RunAll(const vector<Closure>& closures, ClosureFrame& frame)
+    {
+        for (auto& closure : closures)
+        {
+            Expected<VarValue> result = closure(frame);
+            if (result.Failed()) return move(result.Error());
+        }
+        return RuntimeError();
+    }
+
+    RuntimeError CheckDefined(const ClosureFrame& frame, unsigned int slot, SymbolId id, const TokenInfo& t)
+    {
+        if (!frame.variables.Exists(slot))
+        {
+            stringstream ss;
+            ss << "Undefined variable: " << Symbols::Name(id) << " @line: " << t.line;
+            return RuntimeError(ss.str());
+        }
+        return RuntimeError();
+    }
+}
+
+
+
+Expected<VarValue> Closures::Run(Interpreter& interpreter, const Function& function, const VariableSet& variables)
+{
+    const Closure& body = function.Bound();
+
+    ClosureFrame frame{ interpreter, variables };
+
+    return body(frame);
+}
+
+const Closure& Function::Bound() const
+{
+    if (!bound.load(memory_order_acquire))
+    {
+        if (Parse()) { throw OperationBugException(BUG_LOCATION); }    // the caller checks the parse error
+
+        lock_guard<mutex> lock(parseMutex);
+
+        if (!bound.load(memory_order_relaxed))
+        {
+            _TRACE_("        BINDING: " << getId() << endl);
+
+            closure = Bind();
+            bound.store(true, memory_order_release);
+        }
+    }
+
+    return closure;
+}
+
+
+
+// Operation::Bind, the callables have the semantics of Operation::Exec
+
+Closure Function::Bind() const
+{
+    unsigned int result = frame.result;
+    vector<Closure> body = BindAll(operations);
+
+    return [result, body](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        frame.variables.Add(result, VarValue()); // add variable for function return value
+
+        RuntimeError error = RunAll(body, frame);
+        if (error) return error;
+
+        return frame.variables.TakeValue(result);
+    };
+}
+
+Closure FunctionCall::Bind() const
+{
+    SymbolId fid = id;
+    TokenInfo tok = t;
+    vector<Closure> params = BindAll(parameters);
+
+    return [fid, tok, params](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        const Function* func = frame.interpreter.Callee(fid);
+
+        if (!func)
+        {
+            stringstream ss;
+            ss << "Function with name \"" << Symbols::Name(fid) << "\" not defined! @Line: " << tok.line;
+            return RuntimeError(ss.str());
+        }
+
+        if (params.size() != func->getParams().size())
+        {
+            stringstream ss;
+            ss << "Function with name \"" << Symbols::Name(fid) << "\" called with " << params.size()
+               << " parameters instead of " << func->getParams().size() << ". @Line: " << tok.line;
+            return RuntimeError(ss.str());
+        }
+
+        RuntimeError error = func->Parse();    // a body that does not parse fails the call before its arguments are evaluated
+
+        if (!error)
+        {
+            const FrameLayout& layout = func->Frame();
+            CallFrame callee(frame.interpreter.frames, layout);
+
+            for (size_t i = 0; i < params.size() && !error; i++)
+            {
+                Expected<VarValue> arg = params[i](frame);  // evaluated in the callers frame
+                if (arg.Failed()) error = move(arg.Error());
+                else callee.variables.Add(layout.params[i], move(arg.Value()));
+            }
+
+            // a pure function called with the same nodes before returns the value of that call
+            MemoKey key(*func);
+            bool memoized = !error && frame.interpreter.Memoized(fid);
+
+            for (size_t i = 0; i < params.size() && memoized; i++)
+            {
+                memoized = key.Add(callee.variables.GetValue(layout.params[i]));
+            }
+
+            const VarValue* known = memoized ? frame.interpreter.memo.Find(key) : nullptr;
+            if (known) return *known;
+
+            if (!error)
+            {
+                size_t handled = frame.interpreter.memo.Errors();
+
+                Expected<VarValue> result = Closures::Run(frame.interpreter, *func, callee.variables);
+                if (!result.Failed())
+                {
+                    if (memoized && frame.interpreter.memo.Errors() == handled) frame.interpreter.memo.Store(key, result.Value());
+                    return result;
+                }
+
+                error = move(result.Error());
+            }
+        }
+
+        frame.interpreter.memo.Handled();
+        RED("RUNTIME ERROR: " << error.what());
+        _TRACE_("        RUNTIME ERROR: " << error.what() << endl);
+        return VarValue();     // handled, the call returns nothing
+    };
+}
+
+Closure SetFunctionValue::Bind() const
+{
+    unsigned int var = slot;
+    Closure value = BindOne(op);
+
+    return [var, value](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> val = value(frame);
+        if (val.Failed()) return move(val.Error());
+
+        frame.variables.Add(var, move(val.Value()));
+        return VarValue();
+    };
+}
+
+Closure ConditionalBlock::Bind() const
+{
+    if (sBlocks.size() == 1) return BindOne(sBlocks[0]);
+    if (pBlocks.size() == 1) return BindOne(pBlocks[0]);
+
+    // every block is evaluated, like in Exec, a block can call functions that print
+    if (sBlocks.size() > 1)
+    {
+        vector<Closure> blocks = BindAll(sBlocks);
+
+        return [blocks](ClosureFrame& frame) -> Expected<VarValue>
+        {
+            bool result = true;
+            for (auto& block : blocks)
+            {
+                Expected<VarValue> val = block(frame);
+                if (val.Failed()) return move(val.Error());
+                result = !val.Value().empty() && result;
+            }
+
+            return result ? TRUE_VALUE : VarValue();
+        };
+    }
+
+    if (pBlocks.size() > 1)
+    {
+        vector<Closure> blocks = BindAll(pBlocks);
+
+        return [blocks](ClosureFrame& frame) -> Expected<VarValue>
+        {
+            bool result = false;
+            for (auto& block : blocks)
+            {
+                Expected<VarValue> val = block(frame);
+                if (val.Failed()) return move(val.Error());
+                result = !val.Value().empty() || result;
+            }
+
+            return result ? TRUE_VALUE : VarValue();
+        };
+    }
+
+    throw OperationBugException(BUG_LOCATION);
+}
+
+Closure IfStmt::Bind() const
+{
+    Closure cond = BindOne(condition);
+    vector<Closure> thanOps = BindAll(thanOperations);
+    vector<Closure> elseOps = BindAll(elseOperations);
+
+    return [cond, thanOps, elseOps](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> val = cond(frame);
+        if (val.Failed()) return move(val.Error());
+
+        RuntimeError error = RunAll(val.Value().empty() ? elseOps : thanOps, frame);
+        if (error) return error;
+
+        return VarValue();
+    };
+}
+
+Closure WhileLoop::Bind() const
+{
+    Closure cond = BindOne(condition);
+    vector<Closure> body = BindAll(operations);
+
+    return [cond, body](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        for (;;)
+        {
+            Expected<VarValue> val = cond(frame);
+            if (val.Failed()) return move(val.Error());
+            if (val.Value().empty()) break;
+
+            RuntimeError error = RunAll(body, frame);
+            if (error) return error;
+        }
+        return VarValue();
+    };
+}
+
+Closure ForLoop::Bind() const
+{
+    unsigned int var = slot;
+    Closure data = BindOne(dataGetter);
+    vector<Closure> body = BindAll(operations);
+
+    return [var, data, body](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> dataSet = data(frame);
+        if (dataSet.Failed()) return move(dataSet.Error());
+
+        for (auto obj : dataSet.Value())
+        {
+            frame.variables.Add(var, VarValue(obj));
+
+            RuntimeError error = RunAll(body, frame);
+            if (error) return error;
+
+            frame.variables.Remove(var);
+        }
+        return VarValue();
+    };
+}
+
+Closure Variable::Bind() const
+{
+    unsigned int var = slot;
+    SymbolId name = id;
+    TokenInfo tok = t;
+
+    if (proven)
+    {
+        return [var](ClosureFrame& frame) -> Expected<VarValue> { return frame.variables.GetValue(var); };
+    }
+
+    return [var, name, tok](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        RuntimeError error = CheckDefined(frame, var, name, tok);
+        if (error) return error;
+
+        return frame.variables.GetValue(var);
+    };
+}
+
+Closure VariableAssignment::Bind() const
+{
+    unsigned int var = slot;
+    Closure value = BindOne(valueGetter);
+
+    return [var, value](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> val = value(frame);
+        if (val.Failed()) return move(val.Error());
+
+        frame.variables.Add(var, move(val.Value()));
+        return VarValue();
+    };
+}
+
+Closure NOT::Bind() const
+{
+    Closure value = BindOne(expression);
+
+    return [value](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> val = value(frame);
+        if (val.Failed()) return move(val.Error());
+
+        return val.Value().empty() ? TRUE_VALUE : VarValue();
+    };
+}
+
+Closure TRUE_VAL::Bind() const
+{
+    return [](ClosureFrame&) -> Expected<VarValue> { return TRUE_VALUE; };
+}
+
+Closure FALSE_VAL::Bind() const
+{
+    return [](ClosureFrame&) -> Expected<VarValue> { return VarValue(); };
+}
+
+Closure NullCheck::Bind() const
+{
+    unsigned int var = slot;
+    SymbolId name = varId;
+    TokenInfo tok = t;
+
+    if (proven)
+    {
+        return [var](ClosureFrame& frame) -> Expected<VarValue> { return frame.variables.GetValue(var).empty() ? TRUE_VALUE : VarValue(); };
+    }
+
+    return [var, name, tok](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        RuntimeError error = CheckDefined(frame, var, name, tok);
+        if (error) return error;
+
+        return frame.variables.GetValue(var).empty() ? TRUE_VALUE : VarValue();
+    };
+}
+
+Closure PRINTS::Bind() const
+{
+    string message = msg;
+
+    return [message](ClosureFrame&) -> Expected<VarValue>
+    {
+        if (0 == message.compare("endl"))
+        {
+            cout << std::endl;
+        }
+        else
+        {
+            _TRACE_(message << endl);
+
+            YELLOW(message);
+        }
+        return VarValue();
+    };
+}
+
+Closure PRINT::Bind() const
+{
+    Closure value = BindOne(operation);
+
+    return [value](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> nodes = value(frame);
+        if (nodes.Failed()) return move(nodes.Error());
+
+        for (auto node : nodes.Value())
+        {
+            auto attribs = frame.interpreter.adapter->GetAttributesOf(node);
+
+            if (attribs)
+            {
+                YELLOW(attribs->ToString());
+                _TRACE_(attribs->ToString() << endl);
+            }
+        }
+        return VarValue();
+    };
+}
+
+Closure CONDITIONS_OF::Bind() const
+{
+    Closure value = BindOne(operation);
+    TokenInfo tok = t;
+
+    return [value, tok](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> result = value(frame);
+        if (result.Failed()) return move(result.Error());
+
+        const VarValue& val = result.Value();
+
+        if (val.empty())
+        {
+            stringstream ss;
+            ss << tok.tok << " called with expression which returned nothing. @Line: " << tok.line;
+            return RuntimeError(ss.str());
+        }
+
+        if (0 == val[0])
+        {
+            stringstream ss;
+            ss << "Operation " << tok.tok << " parameter is NULL pointer. @Line: " << tok.line;
+            return RuntimeError(ss.str());
+        }
+
+        return VarValue(frame.interpreter.adapter->GetGeogConds(val[0]), &frame.interpreter.memory);
+    };
+}
+
+Closure PARENT::Bind() const
+{
+    Closure value = BindOne(operation);
+
+    return [value](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        Expected<VarValue> result = value(frame);
+        if (result.Failed()) return move(result.Error());
+
+        const VarValue& val = result.Value();
+        return val.empty() ? VarValue() : VarValue(frame.interpreter.adapter->GetParentsForNode(val[0]), &frame.interpreter.memory);
+    };
+}
+
+Closure GET_NODES_OF_TYPE::Bind() const
+{
+    string type = typeName;
+    TokenInfo tok = t;
+
+    return [type, tok](ClosureFrame& frame) -> Expected<VarValue>
+    {
+        if (!frame.interpreter.adapter->Exists(type))
+        {
+            stringstream ss;
+            ss << "Parameter \"" << type << "\" of " << tok.tok << " is not a known Node Type. @Line: " << tok.line;
+            return RuntimeError(ss.str());
+        }
+
+        return VarValue(frame.interpreter.adapter->GetAllNodesOfType(type, 0), &frame.interpreter.memory);
+    };
+}
+
+Closure AttributeCheck::Bind() const
+{
+    return [this](ClosureFrame& frame) { return Evaluate(frame.variables, frame.interpreter.adapter); };
+}
+
+Closure CompareAttribute::Bind() const
+{
+    return [this](ClosureFrame& frame) { return Evaluate(frame.variables, frame.interpreter.adapter); };
+}
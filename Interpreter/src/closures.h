@@ -0,0 +1,30 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "types.h"
+#include "variable_set.h"
+#include "operation_exceptions.h"
+
+class Interpreter;
+class Function;
+
+// Operation trees bound to callables
+// ==================================
+// Every operation of a function body is turned once, on the first call of the function, into a
+// callable with its operands captured. Callables return their value instead of passing it through
+// the return slot of the interpreter, each call runs with its own set of variables.
+struct ClosureFrame
+{
+    Interpreter& interpreter;
+    VariableSet variables;
+};
+
+typedef std::function<Expected<VarValue>(ClosureFrame&)> Closure;    // statements return an empty value
+
+namespace Closures
+{
+    // runs a function in a frame pushed with its parameters set, a runtime error is handled by
+    // the innermost call in progress like in FunctionCall::Exec, the outermost one is returned
+    Expected<VarValue> Run(Interpreter& interpreter, const Function& function, const VariableSet& variables);
+}
@@ -0,0 +1,91 @@
+#include "execution_memory.h"
+#include <algorithm>
+
+using namespace std;
+
+static const size_t DEFAULT_INITIAL_SIZE = 64 * 1024;
+
+
+
+void* ExecutionMemory::Heap::do_allocate(size_t size, size_t alignment)
+{
+    blocks++;
+    bytes += size;
+    return pmr::new_delete_resource()->allocate(size, alignment);
+}
+
+void ExecutionMemory::Heap::do_deallocate(void* p, size_t size, size_t alignment)
+{
+    pmr::new_delete_resource()->deallocate(p, size, alignment);
+}
+
+bool ExecutionMemory::Heap::do_is_equal(const pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+
+
+ExecutionMemory::ExecutionMemory()
+    : initialSize(0)
+{
+    SetInitialSize(DEFAULT_INITIAL_SIZE);
+}
+
+void ExecutionMemory::SetInitialSize(size_t size)
+{
+    initialSize = max(size, (size_t)1);
+    initial.reset(new char[initialSize]);
+
+    stats = ExecutionMemoryStats();
+    stats.initialSize = initialSize;
+}
+
+void ExecutionMemory::Begin()
+{
+    stats.allocations = 0;
+    stats.bytes = 0;
+    heap.blocks = 0;
+    heap.bytes = 0;
+
+    arena.emplace(initial.get(), initialSize, &heap);
+}
+
+void ExecutionMemory::End()
+{
+    arena.reset();      // frees the heap blocks, the initial one is used again by the next execution
+
+    stats.heapBlocks = heap.blocks;
+    stats.heapBytes = heap.bytes;
+    stats.largest = max(stats.largest, stats.bytes);
+}
+
+ExecutionMemoryStats ExecutionMemory::Stats() const
+{
+    return stats;
+}
+
+void* ExecutionMemory::do_allocate(size_t size, size_t alignment)
+{
+    if (!arena)
+    {
+        return pmr::new_delete_resource()->allocate(size, alignment);    // outside of an execution
+    }
+
+    stats.allocations++;
+    stats.bytes += size;
+    return arena->allocate(size, alignment);
+}
+
+void ExecutionMemory::do_deallocate(void* p, size_t size, size_t alignment)
+{
+    if (!arena)
+    {
+        pmr::new_delete_resource()->deallocate(p, size, alignment);
+    }
+}
+
+bool ExecutionMemory::do_is_equal(const pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+struct ExecutionMemoryStats
+{
+    size_t initialSize = 0;     // of the arena, SetExecutionMemory
+    size_t allocations = 0;     // by the last Execute
+    size_t bytes = 0;           // requested by the last Execute
+    size_t heapBlocks = 0;      // taken from the heap by the last Execute, when the initial block was full
+    size_t heapBytes = 0;
+    size_t largest = 0;         // most bytes requested by one Execute since the size was set
+};
+
+// Memory of an execution
+// ======================
+// The values an Execute call builds, the node sets of the adapter results and the stacks of the
+// bytecode engine, are taken from a monotonic arena: an allocation moves a pointer, freeing is a
+// no-op and everything is released at once when Execute ends. The arena starts with a block of
+// the initial size that is kept from one Execute to the next, when it is full the arena takes
+// growing blocks from the heap that are freed at the end. An initial size of 'largest' makes the
+// execution of a rule set allocation free.
+//
+// Values must not outlive the execution, Execute clears the frame stack before it ends it.
+class ExecutionMemory : public std::pmr::memory_resource
+{
+private:
+    class Heap : public std::pmr::memory_resource   // the blocks beyond the initial one, counted
+    {
+    public:
+        size_t blocks = 0;
+        size_t bytes = 0;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    std::unique_ptr<char[]> initial;
+    size_t initialSize;
+    Heap heap;
+    std::optional<std::pmr::monotonic_buffer_resource> arena;  // only during an execution
+    ExecutionMemoryStats stats;
+
+public:
+    ExecutionMemory();
+    ExecutionMemory(const ExecutionMemory&) = delete;
+    ExecutionMemory& operator=(const ExecutionMemory&) = delete;
+
+    void SetInitialSize(size_t size);
+    void Begin();   // at the start of Execute
+    void End();     // at the end of Execute, the values allocated since Begin must be destroyed
+    ExecutionMemoryStats Stats() const;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
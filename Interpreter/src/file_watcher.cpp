@@ -0,0 +1,87 @@
+#include "file_watcher.h"
+#include "trace.h"
+#include "utils.h"
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+FileWatcher::FileWatcher(vector<string> dirs, unsigned int quiet, function<void()> onChange)
+    : directories(dirs), changed(onChange), quietMs(quiet), stopEvent(0)
+{
+    if (directories.size() + 1 > MAXIMUM_WAIT_OBJECTS)
+    {
+        stringstream ss;
+        ss << "Cannot watch more than " << MAXIMUM_WAIT_OBJECTS - 1 << " directories.";
+        throw invalid_argument(ss.str().c_str());
+    }
+
+    stopEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    for (auto& dir : directories)
+    {
+        HANDLE handle = FindFirstChangeNotificationA(dir.c_str(), FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE);
+
+        if (INVALID_HANDLE_VALUE == handle)
+        {
+            for (auto h : notifications) FindCloseChangeNotification(h);
+            CloseHandle(stopEvent);
+
+            stringstream ss;
+            ss << "Cannot watch directory: " << dir;
+            throw invalid_argument(ss.str().c_str());
+        }
+
+        notifications.push_back(handle);
+    }
+
+    thread = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher()
+{
+    SetEvent(stopEvent);
+    thread.join();
+
+    for (auto h : notifications) FindCloseChangeNotification(h);
+    CloseHandle(stopEvent);
+}
+
+void FileWatcher::Run()
+{
+    vector<HANDLE> handles(notifications.begin(), notifications.end());
+    handles.push_back(stopEvent);
+
+    const DWORD count = (DWORD)handles.size();
+    const DWORD stop = WAIT_OBJECT_0 + count - 1;
+
+    while (true)
+    {
+        DWORD signaled = WaitForMultipleObjects(count, handles.data(), FALSE, INFINITE);
+        if (signaled == stop || signaled >= WAIT_OBJECT_0 + count) return;
+
+        // wait until the directories are quiet, re-arming every notification that fires meanwhile
+        while (signaled != WAIT_TIMEOUT)
+        {
+            if (signaled == stop || signaled >= WAIT_OBJECT_0 + count) return;
+
+            FindNextChangeNotification(handles[signaled - WAIT_OBJECT_0]);
+            signaled = WaitForMultipleObjects(count, handles.data(), FALSE, quietMs);
+        }
+
+        _TRACE_("        FILE WATCHER: changes in the watched directories" << endl);
+
+        changed();
+    }
+}
+
+string FileWatcher::DirectoryOf(const string& path)
+{
+    size_t slash = path.find_last_of("\\/");
+
+    if (slash == string::npos) return ".";
+    if (slash == 0) return path.substr(0, 1);
+
+    return path.substr(0, slash);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+
+// Watches directories for files that are written, created, renamed or deleted and calls 'changed'
+// on its own thread. A burst of changes (e.g. an editor saving several files) is reported once,
+// after 'quietMs' without further changes. The destructor stops the thread, waiting for a running callback.
+class FileWatcher
+{
+private:
+    std::vector<std::string> directories;
+    std::function<void()> changed;
+    unsigned int quietMs;
+    std::vector<void*> notifications;   // change notification handle per directory
+    void* stopEvent;
+    std::thread thread;
+
+private:
+    void Run();
+
+public:
+    // throws invalid_argument if a directory cannot be watched
+    FileWatcher(std::vector<std::string> directories, unsigned int quietMs, std::function<void()> changed);
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    const std::vector<std::string>& Directories() const { return directories; }
+
+    static std::string DirectoryOf(const std::string& path);   // "." for a bare file name
+};
@@ -0,0 +1,260 @@
+#include "frames.h"
+#include "operations.h"
+#include "operation_exceptions.h"
+#include "trace.h"
+
+using namespace std;
+
+
+
+FrameResolver::FrameResolver(FrameLayout& frame, SymbolId function, const vector<SymbolId>& parameters)
+    : layout(frame)
+{
+    layout = FrameLayout();
+
+    for (auto param : parameters)
+    {
+        layout.params.push_back(Slot(param));
+    }
+
+    layout.result = Slot(function);
+
+    // the caller sets the parameters, the function sets its return value before the body runs
+    for (auto slot : layout.params) Define(slot);
+    Define(layout.result);
+}
+
+unsigned int FrameResolver::Slot(SymbolId id)
+{
+    auto it = slots.find(id);
+    if (it == slots.end())
+    {
+        it = slots.emplace(id, (unsigned int)layout.names.size()).first;
+        layout.names.push_back(id);
+        defined.push_back(0);
+    }
+    return it->second;
+}
+
+bool FrameResolver::Defined(unsigned int slot) const
+{
+    return defined[slot] != 0;
+}
+
+void FrameResolver::Define(unsigned int slot)
+{
+    defined[slot] = 1;
+}
+
+void FrameResolver::Undefine(unsigned int slot)
+{
+    defined[slot] = 0;
+}
+
+void FrameResolver::Call(SymbolId function, size_t arguments, int line)
+{
+    layout.calls.push_back({ function, (unsigned int)arguments, line });
+}
+
+void FrameResolver::Restore(const vector<char>& state)
+{
+    for (size_t i = 0; i < defined.size(); i++)
+    {
+        defined[i] = i < state.size() ? state[i] : 0;   // slots added since are not defined
+    }
+}
+
+void FrameResolver::Merge(const vector<char>& state)
+{
+    for (size_t i = 0; i < defined.size(); i++)
+    {
+        defined[i] = defined[i] && i < state.size() && state[i];
+    }
+}
+
+void FrameResolver::Repeat(const function<void()>& round)
+{
+    for (;;)
+    {
+        vector<char> start = defined;
+
+        round();
+        Merge(start);   // the loop may run this round or not, and again from here
+
+        start.resize(defined.size(), 0);
+        if (defined == start) break;
+    }
+}
+
+void FrameResolver::Expression(const OP_PTR& op)
+{
+    if (!op) { throw OperationBugException(BUG_LOCATION); }
+    op->Resolve(*this);
+}
+
+void FrameResolver::Statements(const OpList& ops)
+{
+    for (auto& op : ops)
+    {
+        if (!op) { throw OperationBugException(BUG_LOCATION); }
+        op->Resolve(*this);
+    }
+}
+
+
+
+void Function::LayOut() const
+{
+    FrameResolver out(frame, id, parameters);
+    out.Statements(operations);
+
+    _TRACE_("        FRAME OF: " << getId() << " " << frame.names.size() << " slots" << endl);
+}
+
+const FrameLayout& Function::Frame() const
+{
+    if (Parse()) { throw OperationBugException(BUG_LOCATION); }    // the caller checks the parse error
+
+    return frame;
+}
+
+
+
+// Operation::Resolve, expressions never define variables of the frame they run in
+
+void Function::Resolve(FrameResolver & out)
+{
+    out.Statements(operations);
+}
+
+void FunctionCall::Resolve(FrameResolver & out)
+{
+    out.Call(id, parameters.size(), t.line);
+
+    for (auto& param : parameters)
+    {
+        out.Expression(param);
+    }
+}
+
+void SetFunctionValue::Resolve(FrameResolver & out)
+{
+    out.Expression(op);
+    slot = out.Slot(functionId);
+    out.Define(slot);
+}
+
+void ConditionalBlock::Resolve(FrameResolver & out)
+{
+    for (auto& block : sBlocks) out.Expression(block);
+    for (auto& block : pBlocks) out.Expression(block);
+}
+
+void IfStmt::Resolve(FrameResolver & out)
+{
+    out.Expression(condition);
+
+    vector<char> before = out.State();
+    out.Statements(thanOperations);
+
+    vector<char> afterThen = out.State();
+    out.Restore(before);
+    out.Statements(elseOperations);
+
+    out.Merge(afterThen);
+}
+
+void WhileLoop::Resolve(FrameResolver & out)
+{
+    out.Repeat([&]()
+    {
+        out.Expression(condition);
+        out.Statements(operations);
+    });
+
+    out.Expression(condition);  // the last evaluation, that ends the loop
+}
+
+void ForLoop::Resolve(FrameResolver & out)
+{
+    out.Expression(dataGetter);
+    slot = out.Slot(id);
+
+    out.Repeat([&]()
+    {
+        out.Define(slot);
+        out.Statements(operations);
+        out.Undefine(slot);     // removed after every round
+    });
+}
+
+void Variable::Resolve(FrameResolver & out)
+{
+    slot = out.Slot(id);
+    proven = out.Defined(slot);
+}
+
+void VariableAssignment::Resolve(FrameResolver & out)
+{
+    out.Expression(valueGetter);
+    slot = out.Slot(id);
+    out.Define(slot);
+}
+
+void NOT::Resolve(FrameResolver & out)
+{
+    out.Expression(expression);
+}
+
+void TRUE_VAL::Resolve(FrameResolver &)
+{
+}
+
+void FALSE_VAL::Resolve(FrameResolver &)
+{
+}
+
+void NullCheck::Resolve(FrameResolver & out)
+{
+    slot = out.Slot(varId);
+    proven = out.Defined(slot);
+}
+
+void PRINTS::Resolve(FrameResolver & out)
+{
+    out.Print();
+}
+
+void PRINT::Resolve(FrameResolver & out)
+{
+    out.Print();
+    out.Expression(operation);
+}
+
+void CONDITIONS_OF::Resolve(FrameResolver & out)
+{
+    out.Expression(operation);
+}
+
+void PARENT::Resolve(FrameResolver & out)
+{
+    out.Expression(operation);
+}
+
+void GET_NODES_OF_TYPE::Resolve(FrameResolver &)
+{
+}
+
+void AttributeCheck::Resolve(FrameResolver & out)
+{
+    slot = out.Slot(varId);
+    proven = out.Defined(slot);
+}
+
+void CompareAttribute::Resolve(FrameResolver & out)
+{
+    slot1 = out.Slot(varId1);
+    proven1 = out.Defined(slot1);
+    slot2 = out.Slot(varId2);
+    proven2 = out.Defined(slot2);
+}
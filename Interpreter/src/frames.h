@@ -0,0 +1,62 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <vector>
+#include "operation.h"
+#include "symbols.h"
+
+// Frame slots of the variables
+// ============================
+// When a function body is parsed, every variable it names gets a fixed slot of the function's frame:
+// first the parameters, then the return value (@Name = ...), then the other #variables in the
+// order of their first use. Names that are equal share a slot, as they shared an entry of the map.
+// Operations keep the slot next to the variable id, which is only used for error messages.
+//
+// The resolver also follows which slots are defined on every path to an operation. A use of such
+// a slot needs no "Undefined variable" check at run time. IF merges its branches, WHILE and FOR are
+// resolved until the set of defined slots is stable, FOR undefines its variable after every round.
+//
+// The calls of the body are listed too, a function table checks them when it links (function_table.h),
+// and whether it prints, which makes it impure (memo.h).
+struct CallSite
+{
+    SymbolId function;
+    unsigned int arguments;
+    int line;
+};
+
+struct FrameLayout
+{
+    std::vector<SymbolId> names;        // variable of every slot
+    std::vector<unsigned int> params;   // slot of every parameter
+    unsigned int result = 0;            // slot of the return value
+    std::vector<CallSite> calls;        // in the order of the body
+    bool prints = false;                // PRINT or PRINTS
+};
+
+class FrameResolver
+{
+private:
+    FrameLayout& layout;
+    std::map<SymbolId, unsigned int> slots;
+    std::vector<char> defined;          // slots defined on every path to the operation being resolved
+
+public:
+    FrameResolver(FrameLayout& layout, SymbolId function, const std::vector<SymbolId>& parameters);
+
+    unsigned int Slot(SymbolId id);     // adds a slot on the first use of a variable
+    bool Defined(unsigned int slot) const;
+    void Define(unsigned int slot);
+    void Undefine(unsigned int slot);
+    void Call(SymbolId function, size_t arguments, int line);
+    void Print() { layout.prints = true; }
+
+    std::vector<char> State() const { return defined; }
+    void Restore(const std::vector<char>& state);
+    void Merge(const std::vector<char>& state);     // defined on both paths
+    void Repeat(const std::function<void()>& round);    // resolves a loop round until the slots defined at its start are stable
+
+    void Expression(const OP_PTR& op);
+    void Statements(const OpList& ops);
+};
@@ -0,0 +1,203 @@
+#include "function_table.h"
+#include "frames.h"
+#include "source_file.h"
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+
+
+FunctionTable::FunctionTable(const Definitions& functions, unsigned int inlining)
+    : entries(functions.begin(), functions.end())
+{
+    // at most half of the slots are used, a search ends at a free slot after a few probes
+    size_t slots = 16;
+    while (slots < 2 * entries.size()) slots *= 2;
+    index.assign(slots, 0);
+
+    SymbolId last = 0;
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].second->getSymbol() >= symFIRST_SESSION)
+        {
+            stringstream ss;
+            ss << "Function \"" << entries[i].first << "\" of an editor session cannot be linked.";
+            throw invalid_argument(ss.str().c_str());
+        }
+
+        size_t slot = SourceFile::Hash(entries[i].first) & (slots - 1);
+        while (index[slot]) slot = (slot + 1) & (slots - 1);
+        index[slot] = (uint32_t)i + 1;
+
+        last = max(last, entries[i].second->getSymbol());
+    }
+
+    callees.assign(entries.empty() ? 0 : last + 1, nullptr);
+
+    for (auto& entry : entries)
+    {
+        callees[entry.second->getSymbol()] = entry.second.get();
+
+        const SOURCE_PTR& source = entry.second->Source();
+        if (find(sources.begin(), sources.end(), source) == sources.end()) sources.push_back(source);
+    }
+
+    // a function is pure if its own body allows it and all its callees are pure, the functions that
+    // call an impure one are removed until no more are
+    pure.assign(callees.size(), 0);
+
+    for (auto& entry : entries)
+    {
+        const Function& func = *entry.second;
+        pure[func.getSymbol()] = !func.IsVolatile() && func.IsParsed() && func.Validate().empty() && !func.Frame().prints && Link(func).empty();
+    }
+
+    for (bool changed = true; changed; )
+    {
+        changed = false;
+
+        for (auto& entry : entries)
+        {
+            const Function& func = *entry.second;
+            if (!pure[func.getSymbol()]) continue;
+
+            for (auto& call : func.Frame().calls)
+            {
+                if (!pure[call.function])
+                {
+                    pure[func.getSymbol()] = 0;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    inlined.assign(callees.size(), 0);
+    expansions.resize(callees.size());
+
+    if (inlining > 0) Expand(inlining);
+}
+
+// The functions are compiled after the callees they may inline, in the order a depth first search
+// over the calls to small functions leaves them. A call to a function still being searched closes a
+// cycle, both ends of it stay calls.
+void FunctionTable::Expand(unsigned int inlining)
+{
+    vector<char> small(callees.size(), 0);
+
+    for (auto& entry : entries)
+    {
+        const Function& func = *entry.second;
+        small[func.getSymbol()] = func.IsParsed() && func.Validate().empty() && Link(func).empty() && func.Compiled().code.size() <= inlining;
+    }
+
+    enum : char { NEW, SEARCHING, DONE };
+    vector<char> state(callees.size(), NEW);
+
+    function<void(const Function&)> search = [&](const Function& func)
+    {
+        SymbolId id = func.getSymbol();
+        state[id] = SEARCHING;
+
+        bool calls = false;     // to an inlined function
+
+        for (auto& call : func.Frame().calls)
+        {
+            if (call.function >= small.size() || !small[call.function]) continue;
+
+            if (state[call.function] == SEARCHING)
+            {
+                small[call.function] = 0;
+                small[id] = 0;
+            }
+            else if (state[call.function] == NEW)
+            {
+                search(*callees[call.function]);
+            }
+
+            calls = calls || inlined[call.function];
+        }
+
+        state[id] = DONE;
+
+        if (calls)
+        {
+            auto expansion = make_unique<Expansion>();
+            expansion->frame = func.Frame();
+
+            BytecodeWriter out(expansion->code, *this, expansion->frame);
+            func.Compile(out);
+
+            if (out.Inlines() > 0) expansions[id] = move(expansion);
+        }
+
+        if (small[id])
+        {
+            const Expansion* expansion = expansions[id].get();
+            inlined[id] = (expansion ? expansion->code.code.size() : func.Compiled().code.size()) <= inlining;
+        }
+    };
+
+    for (auto& entry : entries)
+    {
+        const Function& func = *entry.second;
+        if (state[func.getSymbol()] == NEW && func.IsParsed() && func.Validate().empty()) search(func);
+    }
+}
+
+const Expansion* FunctionTable::Expanded(const Function& func) const
+{
+    SymbolId id = func.getSymbol();
+    return id < expansions.size() && callees[id] == &func ? expansions[id].get() : nullptr;
+}
+
+FunctionTable::Definitions FunctionTable::Copy() const
+{
+    return Definitions(entries.begin(), entries.end());
+}
+
+Function* FunctionTable::Find(string_view name) const
+{
+    size_t mask = index.size() - 1;
+
+    for (size_t slot = SourceFile::Hash(name) & mask; index[slot]; slot = (slot + 1) & mask)
+    {
+        const Entry& entry = entries[index[slot] - 1];
+        if (entry.first == name) return entry.second.get();
+    }
+
+    return nullptr;
+}
+
+vector<string> FunctionTable::Link(const Function& caller) const
+{
+    vector<string> errors;
+
+    if (!caller.IsParsed() || !caller.Validate().empty()) return errors;   // parse errors are reported on their own
+
+    for (auto& call : caller.Frame().calls)
+    {
+        const Function* callee = Callee(call.function);
+
+        if (!callee)
+        {
+            stringstream ss;
+            ss << "Function with name \"" << Symbols::Name(call.function) << "\" not defined! @Line: " << call.line;
+            errors.push_back(ss.str());
+        }
+        else if (call.arguments != callee->getParams().size())
+        {
+            stringstream ss;
+            ss << "Function with name \"" << Symbols::Name(call.function) << "\" called with " << call.arguments
+               << " parameters instead of " << callee->getParams().size() << ". @Line: " << call.line;
+            errors.push_back(ss.str());
+        }
+    }
+
+    return errors;
+}
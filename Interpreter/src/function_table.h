@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "operations.h"
+#include "symbols.h"
+
+// Function table
+// ==============
+// The functions of a load by name. A table is built once from the definitions of the load and not
+// changed after, the next load builds a new one. Names are found in an open addressing index over
+// the entries, hashed and compared as string_view, so Execute looks up the names it is given
+// without copying them. Iterating gives the functions in the order of their names.
+//
+// Building the table links it: the callee of every name is put into an array indexed by SymbolId.
+// The engines take the callee of a call site from there with the id the call site keeps, without
+// hashing its name. Function objects are shared by the tables of reloads and by the interpreters
+// that import the same module, so the binding is kept by the table and not by the call site; an
+// execution calls the functions of the table it started with. Link checks the calls of a parsed
+// body against the table, before they run.
+//
+// The table also knows which functions are pure: their body was parsed when the table was built,
+// does not print, is not VOLATILE and calls only pure functions with the right number of arguments.
+// The results of pure functions are memoized during an execution (memo.h).
+//
+// The inliner writes the bodies of small functions into their callers, for the bytecode engine. A
+// function is inlined if its body was parsed, its calls link, it compiles to at most the given number
+// of instructions with its own callees inlined and it does not reach itself through other inlined
+// functions. The callers are compiled again when the table is built and the table keeps that code:
+// the same function may be the caller of other callees in the table of another load.
+//
+// The table keeps the rule files of its functions (source_file.h). The tokens of its code and of the
+// functions point into them, also those of an inlined body into the file of the callee.
+struct Expansion
+{
+    FrameLayout frame;      // the slots of the function, then those of every inlined body
+    Bytecode code;
+};
+
+class FunctionTable
+{
+public:
+    typedef std::map<std::string, FUNC_PTR, std::less<>> Definitions;     // what a load builds a table from
+    typedef std::pair<std::string, FUNC_PTR> Entry;
+    typedef std::vector<Entry>::const_iterator const_iterator;
+
+private:
+    std::vector<Entry> entries;             // by name
+    std::vector<uint32_t> index;            // entry + 1 of every used slot, 0 for a free one
+    std::vector<Function*> callees;     // by SymbolId, null for the names that are not functions
+    std::vector<char> pure;             // by SymbolId
+    std::vector<char> inlined;          // by SymbolId
+    std::vector<std::unique_ptr<const Expansion>> expansions;  // by SymbolId, null for the functions that inline no call
+    std::vector<SOURCE_PTR> sources;    // of the functions, each file once
+
+private:
+    void Expand(unsigned int inlining);
+
+public:
+    FunctionTable() : FunctionTable(Definitions()) {}
+    explicit FunctionTable(const Definitions& functions, unsigned int inlining = 0);     // inlining: instructions of the largest inlined body, 0 = none
+
+    Definitions Copy() const;   // the definitions, for the next table
+
+    Function* Find(std::string_view name) const;     // null if there is no function of the name
+    Function* Callee(SymbolId id) const { return id < callees.size() ? callees[id] : nullptr; }
+    bool Pure(SymbolId id) const { return id < pure.size() && pure[id]; }
+    bool Inlined(SymbolId id) const { return id < inlined.size() && inlined[id]; }
+    const Expansion* Expanded(const Function& func) const;     // the code of the function with its callees inlined, null if there is none
+
+    std::vector<std::string> Link(const Function& caller) const;   // errors of the calls of a parsed body, nothing for a body not parsed yet
+
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+    size_t size() const { return entries.size(); }
+};
@@ -0,0 +1,195 @@
+#include "incremental_parser.h"
+#include "trace.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+IncrementalParser::IncrementalParser(string filePath, string contents)
+    : path(filePath), text(contents)
+{
+    bool truncated;
+    spans = Scan(0, (unsigned int)text.size(), 1, truncated);
+
+    if (spans.empty())
+    {
+        spans.push_back(Span());     // an empty text is one empty span
+    }
+}
+
+void IncrementalParser::Edit(unsigned int begin, unsigned int end, string_view replacement)
+{
+    if (begin > end || end > text.size())
+    {
+        stringstream ss;
+        ss << "Edit range [" << begin << ", " << end << ") is outside of the text (" << text.size() << " characters).";
+        throw invalid_argument(ss.str().c_str());
+    }
+
+    size_t first = SpanAt(begin);
+    size_t last = (end > begin) ? SpanAt(end - 1) : first;
+
+    int removedNewlines = 0;
+    for (size_t i = first; i <= last; i++) removedNewlines += spans[i].newlines;
+
+    text.replace(begin, end - begin, replacement);
+    const long long delta = (long long)replacement.size() - (end - begin);
+
+    const unsigned int regionBegin = spans[first].begin;
+    vector<Span> fresh;
+
+    while (true)
+    {
+        unsigned int regionEnd = (unsigned int)(spans[last].end + delta);
+
+        // the region must end at the start of a line, otherwise its last line continues in the next span ...
+        bool lineCut = regionEnd == 0 || regionEnd >= text.size() || text[regionEnd - 1] == '\n';
+
+        if (!lineCut && last + 1 < spans.size())
+        {
+            removedNewlines += spans[++last].newlines;
+            continue;
+        }
+
+        bool truncated;
+        fresh = Scan(regionBegin, regionEnd, spans[first].line, truncated);
+
+        // ... and must not end inside a definition, e.g. when its END was deleted
+        if (truncated && last + 1 < spans.size())
+        {
+            removedNewlines += spans[++last].newlines;
+            continue;
+        }
+
+        break;
+    }
+
+    int addedNewlines = 0;
+    for (auto& span : fresh) addedNewlines += span.newlines;
+    const int lineDelta = addedNewlines - removedNewlines;
+
+    _TRACE_("        INCREMENTAL PARSE: spans " << first << " - " << last << " re-parsed as " << fresh.size() << " spans" << endl);
+
+    spans.erase(spans.begin() + first, spans.begin() + last + 1);
+    spans.insert(spans.begin() + first, fresh.begin(), fresh.end());
+
+    size_t i = first + fresh.size();
+    while (i < spans.size())
+    {
+        Span& span = spans[i];
+        span.begin = (unsigned int)(span.begin + delta);
+        span.end = (unsigned int)(span.end + delta);
+        span.line += lineDelta;
+
+        if (!lineDelta)
+        {
+            i++;
+            continue;
+        }
+
+        if (span.error.empty())
+        {
+            for (auto& function : span.functions) function->ShiftLines(lineDelta);
+            i++;
+            continue;
+        }
+
+        // the error message of a moved span refers to its old lines
+        bool truncated;
+        vector<Span> parts = Scan(span.begin, span.end, span.line, truncated);
+
+        spans.erase(spans.begin() + i);
+        spans.insert(spans.begin() + i, parts.begin(), parts.end());
+        i += parts.size();
+    }
+
+    if (spans.empty())
+    {
+        spans.push_back(Span());     // an empty text is one empty span
+    }
+}
+
+vector<FUNC_PTR> IncrementalParser::Functions() const
+{
+    vector<FUNC_PTR> functions;
+    for (auto& span : spans)
+    {
+        functions.insert(functions.end(), span.functions.begin(), span.functions.end());
+    }
+    return functions;
+}
+
+vector<string> IncrementalParser::Errors() const
+{
+    vector<string> errors;
+    for (auto& span : spans)
+    {
+        if (!span.error.empty()) errors.push_back(span.error);
+    }
+    return errors;
+}
+
+// lexes and parses text[begin, end), which starts at the beginning of a line
+vector<IncrementalParser::Span> IncrementalParser::Scan(unsigned int begin, unsigned int end, int line, bool& truncated) const
+{
+    vector<Span> result;
+    truncated = false;
+
+    if (begin == end) return result;
+
+    SymbolSession::Scope session(symbols);
+    SOURCE_PTR source = SourceFile::FromText(path, text.substr(begin, end - begin));
+    string_view src = source->Text();
+    const unsigned int size = (unsigned int)src.size();
+
+    LangParser parser;
+    SplitResult split = parser.split(source, { 0, size, line });
+    truncated = split.truncated;
+
+    // a span ends with the line of an END, unless the next definition starts on that line.
+    // The last span also holds whatever follows the last definition (e.g. one that could not be split).
+    vector<unsigned int> cuts;
+    for (size_t i = 0; i + 1 < split.definitions.size(); i++)
+    {
+        size_t cut = src.find('\n', split.definitions[i].end);
+        cut = (cut == string_view::npos) ? size : cut + 1;
+
+        if (cut <= split.definitions[i + 1].begin) cuts.push_back((unsigned int)cut);
+    }
+    cuts.push_back(size);
+
+    // only comments and IMPORTs, e.g. what is left when a whole definition is deleted
+    const bool empty = split.definitions.empty() && split.error.empty();
+
+    unsigned int from = 0;
+    for (unsigned int cut : cuts)
+    {
+        Span span;
+        span.begin = begin + from;
+        span.end = begin + cut;
+        span.line = line;
+        span.newlines = (int)count(src.begin() + from, src.begin() + cut, '\n');
+
+        if (!empty)
+        {
+            ParseResult parsed = parser.parse(source, { from, cut, line });
+            span.functions = move(parsed.functions);
+            span.error = move(parsed.error);
+        }
+
+        result.push_back(move(span));
+
+        line += result.back().newlines;
+        from = cut;
+    }
+
+    return result;
+}
+
+size_t IncrementalParser::SpanAt(unsigned int offset) const
+{
+    auto it = upper_bound(spans.begin(), spans.end(), offset, [](unsigned int o, const Span& s) { return o < s.begin; });
+
+    return (it == spans.begin()) ? 0 : (it - spans.begin() - 1);
+}
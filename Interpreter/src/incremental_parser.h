@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "operations.h"
+#include "parser.h"
+#include "source_file.h"
+#include "symbols.h"
+
+// Incremental front end for editors that validate while the user types
+// ====================================================================
+// The text is kept as a list of spans: runs of whole lines holding one function definition
+// (more if a definition starts on the line where the previous one ENDs) together with the
+// comments and empty lines before it. An edit re-lexes and re-parses only the spans it touches;
+// the functions of the other spans are reused. If the edit leaves a definition without its END,
+// the following spans are taken in until the definition is closed again.
+//
+// Every re-parsed part of the text gets its own SourceFile, so an unchanged function keeps only
+// the text it was parsed from alive. The functions of spans after an edit that added or removed
+// lines are moved to their new lines (Function::ShiftLines); a span with an error is re-parsed,
+// its message has the old line in it.
+//
+// The names that are not in the loaded rules are interned into a session of the parser, so the partial
+// names typed while editing are freed with the parser. Symbols::Name finds them as long as the parser exists.
+class IncrementalParser
+{
+private:
+    struct Span
+    {
+        unsigned int begin = 0;         // offset in the text, at the start of a line
+        unsigned int end = 0;           // offset past the last character
+        int line = 1;                   // line of 'begin'
+        int newlines = 0;               // '\n' characters in the span
+        std::vector<FUNC_PTR> functions;
+        std::string error;              // the parse of the span stopped here
+    };
+
+    std::string path;
+    std::string text;
+    std::vector<Span> spans;            // cover the whole text, in order
+    mutable SymbolSession symbols;      // open on the thread of a parse
+
+private:
+    std::vector<Span> Scan(unsigned int begin, unsigned int end, int line, bool& truncated) const;
+    size_t SpanAt(unsigned int offset) const;
+
+public:
+    IncrementalParser(std::string path, std::string text);
+
+    // replaces text[begin, end), throws invalid_argument if the range is outside of the text
+    void Edit(unsigned int begin, unsigned int end, std::string_view replacement);
+
+    const std::string& Text() const { return text; }
+    std::vector<FUNC_PTR> Functions() const;
+    std::vector<std::string> Errors() const;   // body errors included, every definition is parsed fully
+};
@@ -4,10 +4,39 @@
 #include "utils.h"
 #include "operations.h"
 #include "operation_exceptions.h"
+#include "parallel.h"
+#include "rule_cache.h"
+#include "module_cache.h"
+#include "parser_exceptions.h"
+#include "vm.h"
+#include "closures.h"
+#include "native_codegen.h"
+#include <set>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
 
 using namespace std;
 
+namespace
+{
+    // the default command of BuildNative, cl has to be on the PATH, e.g. in a developer command prompt
+    const char* const MSVC_COMPILER = "cl /nologo /LD /O2 /EHsc /std:c++17 /Brepro /I{include} {source} /Fe{library}";
 
+    // a path as one argument of the command of BuildNative. Between double quotes the shell takes every
+    // character literally except the quote itself and '%' (cmd.exe expands variables there), those are refused.
+    string QuotedPath(const string& path)
+    {
+        if (path.find_first_of("\"%") != string::npos)
+        {
+            stringstream ss;
+            ss << "Path \"" << path << "\" cannot be passed to the native compiler.";
+            throw invalid_argument(ss.str().c_str());
+        }
+        return "\"" + path + "\"";
+    }
+}
 
 ScriptInterpreter::ScriptInterpreter(IAdapter * const adapter)
     : interpreter(adapter)
@@ -24,6 +53,91 @@ void ScriptInterpreter::Load(vector<string> filePaths)
     interpreter.Load(filePaths);
 }
 
+void ScriptInterpreter::Reload(vector<string> filePaths)
+{
+    interpreter.Reload(filePaths);
+}
+
+void ScriptInterpreter::SetLoadThreads(unsigned int count)
+{
+    interpreter.SetLoadThreads(count);
+}
+
+void ScriptInterpreter::SetRuleCache(bool enabled, string directory)
+{
+    interpreter.SetRuleCache(enabled, directory);
+}
+
+void ScriptInterpreter::LoadBundle(string bundlePath)
+{
+    interpreter.LoadBundle(bundlePath);
+}
+
+void ScriptInterpreter::SaveBundle(string bundlePath)
+{
+    interpreter.SaveBundle(bundlePath);
+}
+
+void ScriptInterpreter::SetLazyParsing(bool enabled)
+{
+    interpreter.SetLazyParsing(enabled);
+}
+
+StrVec ScriptInterpreter::Validate()
+{
+    return interpreter.Validate();
+}
+
+void ScriptInterpreter::WatchRuleFiles(bool enabled)
+{
+    interpreter.WatchRuleFiles(enabled);
+}
+
+void ScriptInterpreter::SetExecutionEngine(ExecutionEngine engine)
+{
+    interpreter.SetExecutionEngine(engine);
+}
+
+void ScriptInterpreter::SetInlining(unsigned int instructions)
+{
+    interpreter.SetInlining(instructions);
+}
+
+void ScriptInterpreter::SetExecutionMemory(size_t initialSize)
+{
+    interpreter.SetExecutionMemory(initialSize);
+}
+
+ExecutionMemoryStats ScriptInterpreter::GetExecutionMemoryStats()
+{
+    return interpreter.GetExecutionMemoryStats();
+}
+
+void ScriptInterpreter::SetMemoization(size_t entries)
+{
+    interpreter.SetMemoization(entries);
+}
+
+MemoStats ScriptInterpreter::GetMemoizationStats()
+{
+    return interpreter.GetMemoizationStats();
+}
+
+void ScriptInterpreter::SetNativeCompiler(string command, string includeDirectory)
+{
+    interpreter.SetNativeCompiler(command, includeDirectory);
+}
+
+void ScriptInterpreter::BuildNative(string libraryPath)
+{
+    interpreter.BuildNative(libraryPath);
+}
+
+void ScriptInterpreter::LoadNative(string libraryPath)
+{
+    interpreter.LoadNative(libraryPath);
+}
+
 vector<string> ScriptInterpreter::GetLoadedFunctions()
 {
     return interpreter.GetLoadedFunctions();
@@ -32,41 +146,513 @@ vector<string> ScriptInterpreter::GetLoadedFunctions()
 
 
 
+RuleEditor::RuleEditor(string filePath, string text)
+    : parser(filePath, text)
+{
+}
+
+void RuleEditor::Edit(unsigned int begin, unsigned int end, string replacement)
+{
+    parser.Edit(begin, end, replacement);
+}
+
+string RuleEditor::GetText()
+{
+    return parser.Text();
+}
+
+vector<RuleFunction> RuleEditor::GetFunctions()
+{
+    vector<RuleFunction> result;
+    for (auto& function : parser.Functions())
+    {
+        RuleFunction info{ string(function->getId()), StrVec(), function->t.line };
+        for (SymbolId param : function->getParams()) info.parameters.push_back(string(Symbols::Name(param)));
+
+        result.push_back(move(info));
+    }
+    return result;
+}
+
+StrVec RuleEditor::GetErrors()
+{
+    return parser.Errors();
+}
+
+
+
+
 Interpreter::Interpreter(IAdapter * const adptr)
-    : adapter(adptr)
+    : adapter(adptr), functions(make_shared<FunctionTable>()), loadThreads(0), ruleCache(false), lazyParsing(false), inlining(0), engine(ExecutionEngine::BYTECODE), watching(false)
 {
     if (!adapter) throw std::invalid_argument("Adapter is null!");
 }
 
+void Interpreter::SetLoadThreads(unsigned int count)
+{
+    loadThreads = count;
+}
+
+void Interpreter::SetRuleCache(bool enabled, string directory)
+{
+    ruleCache = enabled;
+    ruleCacheDirectory = directory;
+}
+
+void Interpreter::SetLazyParsing(bool enabled)
+{
+    lazyParsing = enabled;
+}
+
+void Interpreter::SetExecutionEngine(ExecutionEngine executionEngine)
+{
+    engine = executionEngine;
+}
+
+void Interpreter::SetInlining(unsigned int instructions)
+{
+    inlining = instructions;
+}
+
+void Interpreter::SetExecutionMemory(size_t initialSize)
+{
+    memory.SetInitialSize(initialSize);
+}
+
+ExecutionMemoryStats Interpreter::GetExecutionMemoryStats() const
+{
+    return memory.Stats();
+}
+
+void Interpreter::SetMemoization(size_t entries)
+{
+    memo.SetSize(entries);
+}
+
+MemoStats Interpreter::GetMemoizationStats() const
+{
+    return memo.Stats();
+}
+
+void Interpreter::SetNativeCompiler(string command, string includeDirectory)
+{
+    nativeCompiler = command.empty() ? MSVC_COMPILER : command;
+    nativeInclude = includeDirectory;
+}
+
+void Interpreter::BuildNative(string libraryPath) const
+{
+    _TRACE_("        " << __FUNCTION__ << endl);
+
+    if (nativeCompiler.empty())
+    {
+        throw invalid_argument("No native compiler set, SetNativeCompiler gives the command and the include directory.");
+    }
+
+    lock_guard<mutex> lock(loadMutex);
+
+    vector<uint64_t> hashes;
+    for (auto& file : files)
+    {
+        hashes.push_back(file.hash);
+    }
+
+    NativeWriter writer(*atomic_load(&functions));
+    string source = writer.Source(hashes);
+
+    string sourcePath = libraryPath.substr(0, libraryPath.find_last_of('.')) + ".cpp";
+    if (sourcePath == libraryPath) sourcePath += ".cpp";
+
+    // binary, so the same rule set gives the same file on every build
+    ofstream file(sourcePath, ios::binary | ios::trunc);
+    file << source;
+    file.close();
+
+    if (!file)
+    {
+        stringstream ss;
+        ss << "Native source \"" << sourcePath << "\" cannot be written.";
+        throw invalid_argument(ss.str().c_str());
+    }
+
+    // native_rules.h of the include directory has to match the one the interpreter was built with
+    string command = nativeCompiler;
+    for (auto& replacement : vector<pair<string, string>>{ { "{source}", QuotedPath(sourcePath) }, { "{library}", QuotedPath(libraryPath) }, { "{include}", QuotedPath(nativeInclude) } })
+    {
+        for (size_t pos = command.find(replacement.first); pos != string::npos; pos = command.find(replacement.first, pos + replacement.second.length()))
+        {
+            command.replace(pos, replacement.first.length(), replacement.second);
+        }
+    }
+
+    _TRACE_("        " << command << endl);
+
+    if (system(command.c_str()) != 0)
+    {
+        stringstream ss;
+        ss << "Native rule set \"" << libraryPath << "\" not built, the compiler failed: " << command;
+        throw invalid_argument(ss.str().c_str());
+    }
+}
+
+void Interpreter::LoadNative(string libraryPath)
+{
+    _TRACE_("        " << __FUNCTION__ << endl);
+
+    string error;
+    shared_ptr<const NativeLibrary> library(NativeLibrary::Open(libraryPath, error));
+
+    if (!library)
+    {
+        // the functions stay interpreted
+        _TRACE_("        NATIVE ERROR: " << error << endl);
+        RED("NATIVE ERROR: " << error << endl);
+    }
+
+    lock_guard<mutex> lock(loadMutex);
+
+    nativeLibrary = library;
+    UpdateNative();
+}
+
+// Publishes the native library if it was built from the rule files now loaded. Called with loadMutex
+// held after a new table is published; native is reset before, so Execute never pairs a table with
+// the library of another one.
+void Interpreter::UpdateNative()
+{
+    shared_ptr<const NativeLibrary> library;
+
+    if (nativeLibrary)
+    {
+        vector<uint64_t> hashes;
+        for (auto& file : files)
+        {
+            hashes.push_back(file.hash);
+        }
+
+        if (nativeLibrary->Matches(hashes))
+        {
+            library = nativeLibrary;
+        }
+        else
+        {
+            _TRACE_("        NATIVE ERROR: \"" << nativeLibrary->Path() << "\" was built from other rule files, they are interpreted" << endl);
+            RED("NATIVE ERROR: \"" << nativeLibrary->Path() << "\" was built from other rule files, they are interpreted" << endl);
+        }
+    }
+
+    atomic_store(&native, library);
+}
+
+vector<string> Interpreter::Validate()
+{
+    _TRACE_("        " << __FUNCTION__ << endl);
+
+    lock_guard<mutex> lock(loadMutex);
+
+    vector<FUNC_PTR> unparsed;
+    for (auto& file : files)
+    {
+        for (auto& func : file.functions)
+        {
+            if (!func->IsParsed()) unparsed.push_back(func);
+        }
+    }
+
+    Parallel::For(unparsed.size(), Parallel::WorkerCount(loadThreads, unparsed.size()), [&](size_t i, unsigned int)
+    {
+        unparsed[i]->Validate();
+    });
+
+    auto table = atomic_load(&functions);
+
+    vector<string> errors;
+    for (auto& file : files)
+    {
+        if (!file.error.empty()) errors.push_back(file.error);
+
+        for (auto& func : file.functions)
+        {
+            string error = func->Validate(); // already parsed, returns the error
+            if (!error.empty())
+            {
+                RED(error << endl);
+                errors.push_back(error);
+            }
+            else if (table->Find(func->getId()) == func.get())
+            {
+                for (auto& linkError : table->Link(*func))
+                {
+                    RED(linkError << endl);
+                    errors.push_back(linkError);
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+void Interpreter::WatchRuleFiles(bool enabled)
+{
+    {
+        lock_guard<mutex> lock(watcherMutex);
+        watching = enabled;
+    }
+
+    UpdateWatcher();
+}
+
+// Called after the user loads, never from the watcher thread: replacing the watcher waits for its thread.
+void Interpreter::UpdateWatcher()
+{
+    lock_guard<mutex> lock(watcherMutex);
+
+    if (!watching)
+    {
+        watcher.reset();
+        return;
+    }
+
+    vector<string> directories;
+    for (auto& path : LoadedPaths(true))
+    {
+        string dir = FileWatcher::DirectoryOf(path);
+        if (find(directories.begin(), directories.end(), dir) == directories.end()) directories.push_back(dir);
+    }
+
+    if (watcher && watcher->Directories() == directories) return;
+
+    watcher.reset();
+
+    if (!directories.empty())
+    {
+        watcher.reset(new FileWatcher(directories, 200, [this]()
+        {
+            try
+            {
+                ReloadFiles(LoadedPaths());
+            }
+            catch (exception& e)
+            {
+                // the table in use stays as it was
+                RED("RELOAD ERROR: " << e.what() << endl);
+            }
+        }));
+    }
+}
+
+vector<string> Interpreter::LoadedPaths(bool withModules) const
+{
+    lock_guard<mutex> lock(loadMutex);
+
+    vector<string> paths;
+    for (auto& file : files)
+    {
+        if (withModules || !file.module) paths.push_back(file.path);
+    }
+    return paths;
+}
+
 void Interpreter::Load(vector<string> paths)
 {
     _TRACE_("        " << __FUNCTION__ << endl);
 
-    LangParser parser;
+    {
+        lock_guard<mutex> lock(loadMutex);
+
+        cout << endl << "Parsing files ..." << endl;
+        _TRACE_("        " << "Parsing files ..." << endl);
+
+        // files are parsed concurrently, one parser per worker ...
+        unsigned int workers = Parallel::WorkerCount(loadThreads, paths.size());
+        vector<LangParser> parsers(workers);
+        vector<ParseResult> results(paths.size());
+
+        unsigned int threads = FileThreads(workers);
+
+        Parallel::For(paths.size(), workers, [&](size_t i, unsigned int worker)
+        {
+            results[i] = LoadFile(parsers[worker], paths[i], threads);
+        });
+
+        AddModules(results);
+
+        // ... and merged in the order of the paths, so the outcome is the same as for a sequential load
+        Merge(results);
+
+        _TRACE_("        " << "Finished parsing files." << endl);
+    }
+
+    UpdateWatcher();
+}
+
+void Interpreter::LoadBundle(string bundlePath)
+{
+    _TRACE_("        " << __FUNCTION__ << endl);
+
+    cout << endl << "Loading rule bundle: " << bundlePath << endl;
+
+    vector<ParseResult> results;
+
+    try
+    {
+        results = RuleCache::Read(SourceFile::Open(bundlePath));
+    }
+    catch (const invalid_argument& e)
+    {
+        _TRACE_("        BUNDLE ERROR: " << e.what() << endl);
+        RED("BUNDLE ERROR: " << e.what() << endl);
+        return;
+    }
+    catch (const ImageException& e)
+    {
+        _TRACE_("        BUNDLE ERROR: " << e.what() << endl);
+        RED("BUNDLE ERROR: " << e.what() << endl);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(loadMutex);
+        Merge(results);
+    }
+
+    UpdateWatcher();
+
+    _TRACE_("        " << "Finished loading rule bundle." << endl);
+}
+
+void Interpreter::SaveBundle(string bundlePath) const
+{
+    lock_guard<mutex> lock(loadMutex);
+
+    for (auto& file : files)
+    {
+        if (!file.error.empty())
+        {
+            stringstream ss;
+            ss << "Rule file " << file.path << " has errors, the bundle is not written.";
+            throw invalid_argument(ss.str().c_str());
+        }
+    }
+
+    RuleCache::Write(bundlePath, files);
+}
+
+// the load threads not busy with other files help parsing a large file (e.g. when one file is loaded)
+unsigned int Interpreter::FileThreads(unsigned int fileWorkers) const
+{
+    unsigned int threads = Parallel::WorkerCount(loadThreads, UINT_MAX);
+
+    return (fileWorkers && threads > fileWorkers) ? threads / fileWorkers : 1;
+}
+
+ParseResult Interpreter::LoadFile(LangParser& parser, const string& path, unsigned int threads) const
+{
+    uint64_t stamp = SourceFile::Stamp(path);   // taken before the file is read, so Reload sees a write during the load
+
+    ParseResult result = ruleCache ? LoadCachedFile(parser, path, threads) : parser.parse(path, lazyParsing, threads);
+    result.stamp = stamp;
+
+    return result;
+}
+
+ParseResult Interpreter::LoadCachedFile(LangParser& parser, const string& path, unsigned int threads) const
+{
+    SOURCE_PTR source;
 
-    cout << endl << "Parsing files ..." << endl;
-    _TRACE_("        " << "Parsing files ..." << endl);
+    try
+    {
+        source = SourceFile::Open(path);
+    }
+    catch (const invalid_argument&)
+    {
+        return parser.parse(path); // reports the error like an uncached load
+    }
 
-    functions.clear();
+    string imagePath = RuleCache::ImagePath(path, ruleCacheDirectory);
 
-    for (auto path : paths)
+    try
     {
-        _TRACE_("        Parsing file: \"" << path << "\"" << endl);
-        vector<FUNC_PTR> res = parser.parse(path);
+        vector<ParseResult> cached = RuleCache::Read(SourceFile::Open(imagePath));
 
-        for (auto func : res)
+        if (cached.size() == 1 && cached[0].hash == source->Hash())
+        {
+            _TRACE_("        Rule image used: " << imagePath << endl);
+
+            cached[0].path = path;
+            return cached[0];
+        }
+    }
+    catch (const invalid_argument&)
+    {
+        // no image yet
+    }
+    catch (const ImageException& e)
+    {
+        _TRACE_("        " << e.what() << endl);
+    }
+
+    ParseResult result = parser.parse(source, false, threads);
+
+    if (result.error.empty()) // images are only kept for files without errors, so errors are reported on every load
+    {
+        try
+        {
+            RuleCache::Write(imagePath, { result });
+        }
+        catch (const invalid_argument& e)
+        {
+            _TRACE_("        Rule image not written: " << e.what() << endl);
+        }
+    }
+
+    return result;
+}
+
+// Appends the modules IMPORTed by the results, also the ones imported by modules. Each module is added
+// once, after the files, in the order of its first IMPORT. A file that is also loaded directly is not added again.
+void Interpreter::AddModules(vector<ParseResult>& results) const
+{
+    set<string> included;
+    for (auto& result : results)
+    {
+        included.insert(ModuleCache::Key(result.path));
+    }
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        vector<string> imports = results[i].imports; // results grows
+
+        for (auto& path : imports)
+        {
+            if (included.insert(ModuleCache::Key(path)).second)
+            {
+                results.push_back(ModuleCache::Get(path));
+            }
+        }
+    }
+}
+
+void Interpreter::Merge(vector<ParseResult> results)
+{
+    FunctionTable::Definitions functions;
+    files = results;
+
+    for (auto& result : results)
+    {
+        ReportFile(result);
+
+        for (auto func : result.functions)
         {
             auto it = functions.find(func->getId());
             if (it != functions.end())
             {
-                _TRACE_("        PARSER ERROR: In file " << path << "\" @line: " << func->t.line <<
-                    " function: \"" << func->getId() << " already defined in another rule file @line: " << (*it).second->t.line << endl);
-                RED(endl << "PARSER ERROR: In file " << path << "\" @line: " << func->t.line <<
-                    " function: \"" << func->getId() << " already defined in another rule file @line: " << (*it).second->t.line << endl);
+                ReportDuplicate(result.path, func, it->second);
             }
             else
             {
-                functions[func->getId()] = func;
+                functions[string(func->getId())] = func;
 
             }
         }
@@ -76,7 +662,224 @@ void Interpreter::Load(vector<string> paths)
 
     cout << endl;
 
-    _TRACE_("        " << "Finished parsing files." << endl);
+    Publish(functions, [](const Function&) { return true; });
+}
+
+void Interpreter::Publish(const FunctionTable::Definitions& definitions, const function<bool(const Function&)>& relinked)
+{
+    auto table = make_shared<const FunctionTable>(definitions, inlining);
+
+    // the calls of the parsed bodies are checked now, the others when they are parsed (Validate)
+    for (auto& file : files)
+    {
+        for (auto& func : file.functions)
+        {
+            if (table->Find(func->getId()) != func.get()) continue;     // a duplicate
+
+            vector<string> errors = table->Link(*func);
+            if (!errors.empty() && relinked(*func)) ReportLink(file.path, errors);
+        }
+    }
+
+    atomic_store(&native, shared_ptr<const NativeLibrary>());
+    atomic_store(&this->functions, table);
+    UpdateNative();
+}
+
+void Interpreter::Reload(vector<string> paths)
+{
+    ReloadFiles(paths);
+    UpdateWatcher();
+}
+
+void Interpreter::ReloadFiles(vector<string> paths)
+{
+    _TRACE_("        " << __FUNCTION__ << endl);
+
+    lock_guard<mutex> lock(loadMutex);
+
+    cout << endl << "Reloading files ..." << endl;
+    _TRACE_("        " << "Reloading files ..." << endl);
+
+    map<string, const ParseResult*> previous;
+    for (auto& file : files)
+    {
+        previous[file.path] = &file;
+    }
+
+    // unchanged files keep their functions, the others are parsed again (concurrently, like in Load)
+    unsigned int workers = Parallel::WorkerCount(loadThreads, paths.size());
+    vector<LangParser> parsers(workers);
+    vector<ParseResult> results(paths.size());
+    vector<char> changed(paths.size(), 1);
+    unsigned int threads = FileThreads(workers);
+
+    Parallel::For(paths.size(), workers, [&](size_t i, unsigned int worker)
+    {
+        uint64_t stamp = SourceFile::Stamp(paths[i]);
+
+        auto it = previous.find(paths[i]);
+        if (it != previous.end() && IsUnchanged(*it->second, stamp))
+        {
+            results[i] = *it->second;
+            results[i].stamp = stamp;
+            changed[i] = 0;
+        }
+        else
+        {
+            results[i] = LoadFile(parsers[worker], paths[i], threads);
+        }
+    });
+
+    // a module is unchanged if the module cache still has the functions this interpreter uses
+    AddModules(results);
+    changed.resize(results.size(), 1);
+
+    for (size_t i = paths.size(); i < results.size(); i++)
+    {
+        auto it = previous.find(results[i].path);
+        if (it != previous.end() && it->second->module && it->second->functions == results[i].functions && it->second->error.empty())
+        {
+            changed[i] = 0;
+        }
+    }
+
+    // names defined by the files that changed or were removed, before and after the reload
+    set<string, less<>> affected;
+    set<const Function*> reloaded;
+    set<string> kept;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (!changed[i])
+        {
+            kept.insert(results[i].path);
+            continue;
+        }
+
+        for (auto& func : results[i].functions)
+        {
+            affected.insert(string(func->getId()));
+            reloaded.insert(func.get());
+        }
+    }
+
+    for (auto& file : files)
+    {
+        if (kept.count(file.path)) continue;
+
+        for (auto& func : file.functions)
+        {
+            affected.insert(string(func->getId()));
+        }
+    }
+
+    // executions that are running keep the current table, the changes go to a new one
+    FunctionTable::Definitions functions = atomic_load(&this->functions)->Copy();
+
+    for (auto& name : affected)
+    {
+        functions.erase(name);
+    }
+
+    // the first definition in load order wins, as in Load. Conflicts of two unchanged files were reported before.
+    size_t reparsed = 0;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto& result = results[i];
+
+        if (changed[i])
+        {
+            ReportFile(result);
+            reparsed++;
+        }
+
+        for (auto& func : result.functions)
+        {
+            if (!affected.count(func->getId())) continue;
+
+            auto it = functions.find(func->getId());
+            if (it != functions.end())
+            {
+                if (changed[i] || reloaded.count(it->second.get()))
+                {
+                    ReportDuplicate(result.path, func, it->second);
+                }
+            }
+            else
+            {
+                functions[string(func->getId())] = func;
+            }
+        }
+
+        if (changed[i]) cout << endl;
+    }
+
+    files = results;
+
+    // the calls of unchanged bodies are checked again if they call a function that changed
+    Publish(functions, [&](const Function& func)
+    {
+        if (reloaded.count(&func)) return true;
+
+        for (auto& call : func.Frame().calls)
+        {
+            if (affected.count(Symbols::Name(call.function))) return true;
+        }
+        return false;
+    });
+
+    cout << reparsed << " of " << results.size() << " files parsed, " << affected.size() << " functions updated" << endl << endl;
+    _TRACE_("        " << "Finished reloading files." << endl);
+}
+
+bool Interpreter::IsUnchanged(const ParseResult& file, uint64_t stamp) const
+{
+    if (!file.error.empty() || !file.stamp) return false;   // files with errors are parsed again, so the errors are reported again
+    if (!stamp) return false;  // removed or not readable, parsing it reports the error
+    if (stamp == file.stamp) return true;
+
+    try
+    {
+        return SourceFile::Open(file.path)->Hash() == file.hash;  // written, but maybe with the same text
+    }
+    catch (const invalid_argument&)
+    {
+        return false;
+    }
+}
+
+void Interpreter::ReportFile(const ParseResult& result) const
+{
+    _TRACE_("        Parsing file: \"" << result.path << "\"" << endl);
+
+    cout << result.path;
+    if (result.error.empty())
+    {
+        cout << "OK";
+    }
+    else
+    {
+        RED(endl << result.error << endl);
+    }
+}
+
+void Interpreter::ReportLink(const string& path, const vector<string>& errors) const
+{
+    for (auto& error : errors)
+    {
+        _TRACE_("        LINK ERROR (file: " << path << ") " << error << endl);
+        RED("LINK ERROR (file: " << path << ") " << error << endl);
+    }
+}
+
+void Interpreter::ReportDuplicate(const string& path, const FUNC_PTR& func, const FUNC_PTR& defined) const
+{
+    _TRACE_("        PARSER ERROR: In file " << path << "\" @line: " << func->t.line <<
+        " function: \"" << func->getId() << " already defined in another rule file @line: " << defined->t.line << endl);
+    RED(endl << "PARSER ERROR: In file " << path << "\" @line: " << func->t.line <<
+        " function: \"" << func->getId() << " already defined in another rule file @line: " << defined->t.line << endl);
 }
 
 vector<bool> Interpreter::Execute(vector<string> functionIds)
@@ -85,14 +888,30 @@ vector<bool> Interpreter::Execute(vector<string> functionIds)
 
     _TRACE_("        " << "Executing operations ..." << endl);
 
+    // the whole call runs on the table published when it starts, a reload meanwhile does not affect it
+    executing = atomic_load(&functions);
+    const FunctionTable& table = *executing;
+
+    // the library is used only if it was published for this table, i.e. no load ran in between
+    auto library = atomic_load(&native);
+    if (atomic_load(&functions) != executing) library.reset();
+
+    // the values of the execution are destroyed before its memory is released, also when an
+    // adapter exception ends it; the old table is freed once no execution holds it
+    struct Execution
+    {
+        Interpreter& interpreter;
+        Execution(Interpreter& in) : interpreter(in) { interpreter.memory.Begin(); interpreter.memo.Begin(); }
+        ~Execution() { interpreter.frames.Clear(); interpreter.stack = VariableSet(); interpreter.memo.End(); interpreter.memory.End(); interpreter.executing.reset(); }
+    } execution(*this);
+
     int idx = 0;
     for (auto functionId : functionIds)
     {
-        auto it = functions.find(functionId);
+        Function* fn = table.Find(functionId);
 
-        if (it != functions.end() && it->second)
+        if (fn)
         {
-            FUNC_PTR fn = it->second;
 
             if (fn->getParams().size() > 0)
             {
@@ -101,24 +920,58 @@ vector<bool> Interpreter::Execute(vector<string> functionIds)
             }
             else
             {
-                try
+                cout << "        [EXECUTING: " << fn->getId() << "]" << endl;
+                _TRACE_("        EXECUTING FUNCTION: \"" << fn->getId() << "\"" << endl);
+
+                int nativeFunction = library ? library->Find(functionId) : -1;
+                RuntimeError error;
+
+                if (nativeFunction >= 0)
                 {
-                    stack.Clear();
+                    bool result = false;
+                    string message;
 
-                    cout << "        [EXECUTING: " << fn->getId() << "]" << endl;
-                    _TRACE_("        EXECUTING FUNCTION: \"" << fn->getId() << "\"" << endl);
+                    if (library->Execute(adapter, &memory, nativeFunction, result, message)) results[idx] = result;
+                    else error = RuntimeError(message);
+                }
+                else if (engine == ExecutionEngine::BYTECODE)
+                {
+                    Vm vm(*this);
+                    Expected<VarValue> result = vm.Call(*fn, nullptr);
 
-                    fn->Exec(*this);
+                    if (result.Failed()) error = move(result.Error());
+                    else results[idx] = !result.Value().empty();
+                }
+                else
+                {
+                    error = fn->Parse();
 
-                    results[idx] = stack.PopReturn().size() > 0; // save return value 
+                    if (!error && engine == ExecutionEngine::CLOSURES)
+                    {
+                        CallFrame call(frames, fn->Frame());
+                        Expected<VarValue> result = Closures::Run(*this, *fn, call.variables);
 
-                    cout << endl << "        [FINISHED: " << functionId << "] => " << results[idx] << endl << endl;
-                    _TRACE_(endl << "        FINISHED: " << functionId << " => " << results[idx] << endl);
+                        if (result.Failed()) error = move(result.Error());
+                        else results[idx] = !result.Value().empty();
+                    }
+                    else if (!error)
+                    {
+                        CallFrame call(frames, fn->Frame());
+                        stack = call.variables;
+                        error = fn->Exec(*this);
+                        if (!error) results[idx] = !stack.PopReturn().empty(); // save return value 
+                    }
                 }
-                catch (const RuntimeException& e)
+
+                if (error)
                 {
-                    RED("RUNTIME ERROR: " << e.what());
-                    _TRACE_("        RUNTIME ERROR: " << e.what() << endl);
+                    RED("RUNTIME ERROR: " << error.what());
+                    _TRACE_("        RUNTIME ERROR: " << error.what() << endl);
+                }
+                else
+                {
+                    cout << endl << "        [FINISHED: " << functionId << "] => " << results[idx] << endl << endl;
+                    _TRACE_(endl << "        FINISHED: " << functionId << " => " << results[idx] << endl);
                 }
             }
         }
@@ -137,36 +990,17 @@ vector<bool> Interpreter::Execute(vector<string> functionIds)
 
 vector<string> Interpreter::GetLoadedFunctions() const
 {
+    auto table = atomic_load(&functions);
+
     vector<string> fnames;
-    for (auto f : functions)
+    for (auto& f : *table)
     {
         fnames.push_back(f.first);
     }
     return fnames;
 }
 
-FUNC_PTR Interpreter::getFunction(string id) const
-{
-    FUNC_PTR res;
-
-    auto it = functions.find(id);
-    if (it != functions.end()) { res = it->second; }
-
-    return res;
-}
-
-void Interpreter::PushStack()
-{
-    callStack.push_back(stack);
-}
-
-void Interpreter::PopStack()
-{
-    stack = callStack.back();
-    callStack.pop_back();
-}
-
-string Interpreter::ValToStr(VarValue val) const
+string Interpreter::ValToStr(const VarValue& val) const
 {
     stringstream ss;
 
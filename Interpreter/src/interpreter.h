@@ -1,32 +1,101 @@
 #pragma once
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 #include "operations.h"
+#include "function_table.h"
+#include "parser.h"
+#include "file_watcher.h"
+#include "native_library.h"
+#include "execution_memory.h"
+#include "memo.h"
 #include "../include/adapter_interface.h"
 
+enum class ExecutionEngine
+{
+    BYTECODE,       // function bodies are compiled on their first call and run by the stack machine (vm.h)
+    CLOSURES,       // function bodies are bound to callables on their first call (closures.h)
+    TREE_WALKER     // Operation::Exec on the parsed trees
+};
+
 class Interpreter
 {
 public:
-    VariableSet stack;
+    VariableSet stack;          // variables of the function running on the tree walker
+    FrameStack frames;
+    ExecutionMemory memory;     // of the values of the running Execute
+    Memo memo;                  // results of the pure functions called by the running Execute
     IAdapter * const adapter;
 private:
-    std::map<std::string, FUNC_PTR> functions;
-    std::vector<VariableSet> callStack;
+    // The function table is immutable once published. Loads build a new table and swap it in
+    // atomically, an execution keeps the table it started with until it finishes.
+    std::shared_ptr<const FunctionTable> functions;
+    std::shared_ptr<const FunctionTable> executing;     // table of the running Execute
+    std::vector<ParseResult> files;     // rule files of the last Load, in load order
+    unsigned int loadThreads;
+    bool ruleCache;
+    std::string ruleCacheDirectory;
+    bool lazyParsing;
+    unsigned int inlining;              // instructions of the largest body written into its callers, 0 = none
+    ExecutionEngine engine;
+    std::string nativeCompiler;         // command of BuildNative, empty until SetNativeCompiler
+    std::string nativeInclude;          // directory of native_rules.h
+    std::shared_ptr<const NativeLibrary> nativeLibrary;     // of the last LoadNative
+    std::shared_ptr<const NativeLibrary> native;            // nativeLibrary if it was built from the loaded files, else null
+    mutable std::mutex loadMutex;       // serializes loads, e.g. a Reload by the watcher and a Load by the user
+    std::mutex watcherMutex;
+    bool watching;
+    std::unique_ptr<FileWatcher> watcher;   // last member, it is stopped before the others are destroyed
 
 public:
     Interpreter(IAdapter * const adapter);
 
     void Load(std::vector<std::string> filePaths);
+    void Reload(std::vector<std::string> filePaths);   // parses only the files changed since the last load, drops the files not listed
+    void SetLoadThreads(unsigned int count); // 0 = one per hardware thread
+    void SetRuleCache(bool enabled, std::string directory = ""); // images are kept next to the rule files if directory is empty
+    void SetLazyParsing(bool enabled);  // Load parses function bodies on first use, files that miss the rule cache are parsed fully
+    std::vector<std::string> Validate();    // parses the bodies not parsed yet, returns the parse errors
+    void WatchRuleFiles(bool enabled);      // reloads the rule files in the background when they change
+    void SetExecutionEngine(ExecutionEngine engine);
+    void SetInlining(unsigned int instructions);   // from the next load, 0 = off
+    void SetExecutionMemory(size_t initialSize);    // first block of the arena of Execute, kept between calls
+    ExecutionMemoryStats GetExecutionMemoryStats() const;
+    void SetMemoization(size_t entries);    // results of pure function calls kept by Execute, 0 = off
+    MemoStats GetMemoizationStats() const;
+    void SetNativeCompiler(std::string command, std::string includeDirectory);    // {source}, {library} and {include} are replaced by the quoted paths, "" = MSVC cl
+    void BuildNative(std::string libraryPath) const;    // compiles the loaded functions to a library
+    void LoadNative(std::string libraryPath);       // Execute runs the functions of the library while the rule files match it
+    void LoadBundle(std::string bundlePath);
+    void SaveBundle(std::string bundlePath) const;
     std::vector<bool> Execute(std::vector<std::string> functions);
     std::vector<std::string> GetLoadedFunctions() const;
 
-    FUNC_PTR getFunction(std::string id) const;
+    Function* Callee(SymbolId id) const { return executing->Callee(id); }    // during Execute, null if there is no such function
+    bool Memoized(SymbolId id) const { return memo.Enabled() && executing->Pure(id); }  // during Execute
+    const Expansion* Expanded(const Function& func) const { return executing->Expanded(func); }   // during Execute, null if nothing was inlined into the function
 
-    void PushStack();
-    void PopStack();
+    std::string ValToStr(const VarValue& val) const;
 
-    std::string ValToStr(VarValue val) const;
+private:
+    void ReloadFiles(std::vector<std::string> paths);
+    void UpdateWatcher();
+    std::vector<std::string> LoadedPaths(bool withModules = false) const;
+    ParseResult LoadFile(LangParser& parser, const std::string& path, unsigned int threads) const;     // threads to parse a large file with
+    ParseResult LoadCachedFile(LangParser& parser, const std::string& path, unsigned int threads) const;
+    unsigned int FileThreads(unsigned int fileWorkers) const;
+    bool IsUnchanged(const ParseResult& file, uint64_t stamp) const;
+    void AddModules(std::vector<ParseResult>& results) const;
+    void Merge(std::vector<ParseResult> results);
+    void Publish(const FunctionTable::Definitions& definitions, const std::function<bool(const Function&)>& relinked);
+    void UpdateNative();
+    void ReportFile(const ParseResult& result) const;
+    void ReportDuplicate(const std::string& path, const FUNC_PTR& func, const FUNC_PTR& defined) const;
+    void ReportLink(const std::string& path, const std::vector<std::string>& errors) const;
 };
 
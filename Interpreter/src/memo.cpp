@@ -0,0 +1,103 @@
+#include "memo.h"
+#include <algorithm>
+
+using namespace std;
+
+static const size_t DEFAULT_ENTRIES = 1024;
+
+
+
+bool MemoKey::Add(const VarValue& argument)
+{
+    if (size + 1 + argument.size() > WORDS) return false;
+
+    words[size++] = argument.size();
+    for (auto node : argument)
+    {
+        words[size++] = reinterpret_cast<uintptr_t>(node);
+    }
+    return true;
+}
+
+
+
+Memo::Memo()
+    : handled(0)
+{
+    SetSize(DEFAULT_ENTRIES);
+}
+
+void Memo::SetSize(size_t size)
+{
+    size_t count = 0;
+    if (size > 0)
+    {
+        for (count = 1; count < size; count *= 2);  // a power of two, the hash is masked
+    }
+
+    entries.clear();
+    entries.resize(count);
+
+    stats = MemoStats();
+    stats.entries = count;
+}
+
+Memo::Entry& Memo::At(const MemoKey& key)
+{
+    uint64_t hash = 14695981039346656037ull ^ reinterpret_cast<uintptr_t>(key.function);
+    for (unsigned int i = 0; i < key.size; i++)
+    {
+        hash = (hash ^ key.words[i]) * 1099511628211ull;
+    }
+    hash ^= hash >> 29;     // the low bits of node pointers are all zero
+
+    return entries[hash & (entries.size() - 1)];
+}
+
+const VarValue* Memo::Find(const MemoKey& key)
+{
+    const Entry& entry = At(key);
+
+    if (entry.function == key.function && entry.size == key.size && equal(key.words, key.words + key.size, entry.words))
+    {
+        stats.hits++;
+        return &entry.result;
+    }
+
+    stats.misses++;
+    return nullptr;
+}
+
+void Memo::Store(const MemoKey& key, const VarValue& result)
+{
+    Entry& entry = At(key);
+
+    entry.function = key.function;
+    entry.size = key.size;
+    copy(key.words, key.words + key.size, entry.words);
+    entry.result = result;
+
+    stats.stored++;
+}
+
+void Memo::Begin()
+{
+    handled = 0;
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.stored = 0;
+}
+
+void Memo::End()
+{
+    for (auto& entry : entries)
+    {
+        entry.function = nullptr;
+        entry.result.clear();   // the sets are in the memory of the execution
+    }
+}
+
+MemoStats Memo::Stats() const
+{
+    return stats;
+}
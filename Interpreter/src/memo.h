@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "types.h"
+
+class Function;
+
+struct MemoStats
+{
+    size_t entries = 0;     // of the cache, SetMemoization
+    size_t hits = 0;        // calls of the last Execute answered from the cache
+    size_t misses = 0;      // calls of the last Execute that ran a pure function
+    size_t stored = 0;      // results stored by the last Execute, a result replaces the one of its entry
+};
+
+// Arguments of a call of a pure function: for every argument the number of its nodes, then the nodes
+class MemoKey
+{
+private:
+    friend class Memo;
+    static const unsigned int WORDS = 16;
+
+    const Function* function;
+    unsigned int size;
+    uintptr_t words[WORDS];
+
+public:
+    explicit MemoKey(const Function& callee) : function(&callee), size(0) {}
+
+    bool Add(const VarValue& argument);     // false if the key is full, the call is not memoized then
+};
+
+// Results of pure functions
+// =========================
+// A pure function (FunctionTable::Pure) only reads the nodes of the adapter, which do not change
+// during an Execute, so a call with the same argument nodes returns the same value. The engines look
+// a call up before they run it and store its value after. The results are kept for one Execute,
+// in a fixed number of entries; a key is hashed to its entry and a new result replaces the old one.
+//
+// A runtime error handled inside a call was printed by it, the value of such a call is not stored
+// so the next call prints the error again. The engines count the errors they handle (Handled).
+class Memo
+{
+private:
+    struct Entry
+    {
+        const Function* function = nullptr;
+        unsigned int size = 0;
+        uintptr_t words[MemoKey::WORDS];
+        VarValue result;
+    };
+
+    std::vector<Entry> entries;
+    size_t handled;         // runtime errors handled since the execution started
+    MemoStats stats;
+
+private:
+    Entry& At(const MemoKey& key);
+
+public:
+    Memo();
+
+    void SetSize(size_t entries);       // 0 turns memoization off
+    bool Enabled() const { return !entries.empty(); }
+
+    const VarValue* Find(const MemoKey& key);                   // null if the call has to run
+    void Store(const MemoKey& key, const VarValue& result);
+
+    void Handled() { handled++; }
+    size_t Errors() const { return handled; }
+
+    void Begin();   // at the start of Execute
+    void End();     // at the end of Execute, before the memory of the execution is released
+    MemoStats Stats() const;
+};
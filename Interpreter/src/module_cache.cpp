@@ -0,0 +1,95 @@
+#include "module_cache.h"
+#include "source_file.h"
+#include "trace.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    struct Module
+    {
+        mutex parseMutex;   // one thread parses, the others importing it wait for the result
+        bool parsed = false;
+        ParseResult result;
+    };
+
+    mutex modulesMutex;
+    unordered_map<string, shared_ptr<Module>> modules;  // by Key
+
+    bool IsCurrent(const ParseResult& result, uint64_t stamp)
+    {
+        if (!stamp) return false;
+        if (stamp == result.stamp) return true;
+
+        try
+        {
+            return SourceFile::Open(result.path)->Hash() == result.hash; // written, but maybe with the same text
+        }
+        catch (const invalid_argument&)
+        {
+            return false;
+        }
+    }
+
+    string FullPath(const string& path)
+    {
+        char buffer[MAX_PATH];
+        DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, buffer, NULL);
+
+        return (length > 0 && length < MAX_PATH) ? string(buffer, length) : path;
+    }
+}
+
+string ModuleCache::Key(const string& path)
+{
+    string key = FullPath(path);
+    transform(key.begin(), key.end(), key.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+
+    return key;
+}
+
+ParseResult ModuleCache::Get(const string& path)
+{
+    string fullPath = FullPath(path);
+
+    shared_ptr<Module> module;
+    {
+        lock_guard<mutex> lock(modulesMutex);
+
+        auto& entry = modules[Key(path)];
+        if (!entry) entry = make_shared<Module>();
+        module = entry;
+    }
+
+    lock_guard<mutex> lock(module->parseMutex);
+
+    uint64_t stamp = SourceFile::Stamp(fullPath);   // taken before the file is read, like Interpreter::LoadFile
+
+    if (module->parsed && IsCurrent(module->result, stamp))
+    {
+        module->result.stamp = stamp;
+        return module->result;
+    }
+
+    _TRACE_("        Parsing module: \"" << fullPath << "\"" << endl);
+
+    LangParser parser;
+    module->result = parser.parse(fullPath);
+    module->result.stamp = stamp;
+    module->result.module = true;
+    module->parsed = true;
+
+    return module->result;
+}
+
+void ModuleCache::Clear()
+{
+    lock_guard<mutex> lock(modulesMutex);
+    modules.clear();
+}
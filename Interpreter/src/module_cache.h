@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include "parser.h"
+
+// Rule files shared with IMPORT
+// =============================
+// A module is parsed once per process. Every interpreter and rule set that imports it gets the same
+// Function objects, executions keep their state in the interpreter, so the functions are not copied.
+// A module whose file was written is parsed again the next time it is imported (or reloaded).
+namespace ModuleCache
+{
+    ParseResult Get(const std::string& path);       // errors are in the result, like for a loaded file
+    std::string Key(const std::string& path);       // identifies a module, however it was imported (full path, lower case)
+    void Clear();                                   // the modules stay alive as long as interpreters use them
+}
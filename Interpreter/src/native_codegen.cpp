@@ -0,0 +1,432 @@
+#include "native_codegen.h"
+#include "operation_exceptions.h"
+#include "../include/native_rules.h"
+#include <iomanip>
+
+using namespace std;
+
+static_assert(NativeRules::EQUAL == (int)CheckType::EQUAL && NativeRules::GE == (int)CheckType::GE, "NativeRules::Check follows CheckType");
+
+namespace
+{
+    const char* CHECK_NAMES[] = { "EQUAL", "STARTS_WITH", "ENDS_WITH", "CONTAINS", "LT", "GT", "LE", "GE" };
+}
+
+
+
+NativeWriter::NativeWriter(const FunctionTable& table)
+    : functions(table), indent(0), locals(0), slots(0)
+{
+    for (auto& entry : functions)
+    {
+        size_t position = index.size();
+        index[entry.first] = position;
+    }
+}
+
+string NativeWriter::Source(const vector<uint64_t>& fileHashes)
+{
+    ostringstream out;
+
+    out << "// Native rule set written by Interpreter::BuildNative, do not edit." << endl;
+    out << "#include \"native_rules.h\"" << endl << endl;
+    out << "using namespace NativeRules;" << endl << endl;
+    out << "namespace" << endl << "{" << endl;
+
+    for (auto& entry : functions)
+    {
+        out << "    Value " << Callee(entry.second->getSymbol()) << "(const Host& host, Value* args);    // @" << entry.first << endl;
+    }
+    out << endl;
+
+    for (auto& entry : functions)
+    {
+        WriteFunction(*entry.second, out);
+    }
+
+    out << "    bool Execute(const Host& host, unsigned int function, bool& result, std::string& error)" << endl;
+    out << "    {" << endl;
+    out << "        try" << endl;
+    out << "        {" << endl;
+    out << "            switch (function)" << endl;
+    out << "            {" << endl;
+    for (auto& entry : functions)
+    {
+        if (entry.second->getParams().empty())
+        {
+            string callee = Callee(entry.second->getSymbol());
+            out << "            case " << index[entry.first] << ": result = !" << callee << "(host, nullptr).empty(); return true;" << endl;
+        }
+    }
+    out << "            default: error = \"The function has parameters.\"; return false;" << endl;
+    out << "            }" << endl;
+    out << "        }" << endl;
+    out << "        catch (const Error& e)" << endl;
+    out << "        {" << endl;
+    out << "            error = e.message;" << endl;
+    out << "            return false;" << endl;
+    out << "        }" << endl;
+    out << "    }" << endl << endl;
+
+    out << "    const uint64_t fileHashes[] = { ";
+    for (auto hash : fileHashes)
+    {
+        out << "0x" << hex << setw(16) << setfill('0') << hash << dec << "ull, ";
+    }
+    out << "0 };" << endl;
+
+    out << "    const char* const functions[] = { ";
+    for (auto& entry : functions)
+    {
+        out << Quote(entry.first) << ", ";
+    }
+    out << "nullptr };" << endl << endl;
+
+    out << "    const RuleSet ruleSet = { NATIVE_RULES_VERSION, " << fileHashes.size() << ", fileHashes, "
+        << functions.size() << ", functions, Execute };" << endl;
+    out << "}" << endl << endl;
+
+    out << "NATIVE_RULES_EXPORT const RuleSet* GetNativeRuleSet()" << endl;
+    out << "{" << endl;
+    out << "    return &ruleSet;" << endl;
+    out << "}" << endl;
+
+    return out.str();
+}
+
+void NativeWriter::WriteFunction(const Function& function, ostream& out)
+{
+    code.str("");
+    indent = 2;
+    locals = 0;
+    slots = 0;
+
+    function.Generate(*this);
+
+    out << "    Value " << Callee(function.getSymbol()) << "(const Host& host, Value* args)    // @" << function.getId() << endl;
+    out << "    {" << endl;
+    out << "        Var v[" << max(slots, 1u) << "];" << endl;
+    out << code.str();
+    out << "    }" << endl << endl;
+}
+
+ostream& NativeWriter::Line()
+{
+    code << string(indent * 4, ' ');
+    return code;
+}
+
+void NativeWriter::Open()
+{
+    code << string(indent * 4, ' ') << "{" << endl;
+    indent++;
+}
+
+void NativeWriter::Close()
+{
+    indent--;
+    code << string(indent * 4, ' ') << "}" << endl;
+}
+
+string NativeWriter::Local(const string& initializer)
+{
+    string name = "t" + to_string(locals++);
+
+    if (initializer.empty()) Line() << "Value " << name << ";" << endl;
+    else Line() << "Value " << name << " = " << initializer << ";" << endl;
+
+    return name;
+}
+
+string NativeWriter::Var(unsigned int slot)
+{
+    slots = max(slots, slot + 1);
+    return "v[" + to_string(slot) + "]";
+}
+
+string NativeWriter::Callee(SymbolId id) const
+{
+    auto it = index.find(Symbols::Name(id));
+    return it == index.end() ? string() : "f" + to_string(it->second);
+}
+
+const Function* NativeWriter::Find(SymbolId id) const
+{
+    return functions.Callee(id);
+}
+
+string NativeWriter::Expression(const OP_PTR& op)
+{
+    if (!op) { throw OperationBugException(BUG_LOCATION); }
+
+    string value = op->Generate(*this);
+
+    if (value.empty()) { throw OperationBugException(BUG_LOCATION); }
+    return value;
+}
+
+void NativeWriter::Statements(const OpList& ops)
+{
+    for (auto& op : ops)
+    {
+        if (!op) { throw OperationBugException(BUG_LOCATION); }
+        op->Generate(*this);    // the value of a call used as a statement is dropped
+    }
+}
+
+string NativeWriter::Quote(string_view text)
+{
+    ostringstream out;
+    out << '"';
+
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (c < 0x20 || c >= 0x7f) out << '\\' << oct << setw(3) << setfill('0') << (int)c << dec;
+        else out << c;
+    }
+
+    out << '"';
+    return out.str();
+}
+
+
+
+// Operation::Generate, the generated code has the semantics of Operation::Exec
+
+string Function::Generate(NativeWriter & out) const
+{
+    string error = Validate();
+    if (!error.empty())
+    {
+        out.Line() << "throw Error{ " << NativeWriter::Quote(error) << " };" << endl;
+        return "";
+    }
+
+    for (size_t i = 0; i < frame.params.size(); i++)
+    {
+        out.Line() << out.Var(frame.params[i]) << " = { true, std::move(args[" << i << "]) };" << endl;
+    }
+
+    out.Line() << out.Var(frame.result) << " = { true, Value() };    // return value" << endl;
+    out.Statements(operations);
+    out.Line() << "return " << out.Var(frame.result) << ".value;" << endl;
+
+    return "";
+}
+
+string FunctionCall::Generate(NativeWriter & out) const
+{
+    string result = out.Local();
+    const Function* target = out.Find(id);
+
+    out.Open();
+
+    if (!target)
+    {
+        stringstream ss;
+        ss << "Function with name \"" << Symbols::Name(id) << "\" not defined! @Line: " << t.line;
+        out.Line() << "throw Error{ " << NativeWriter::Quote(ss.str()) << " };" << endl;
+    }
+    else if (parameters.size() != target->getParams().size())
+    {
+        stringstream ss;
+        ss << "Function with name \"" << Symbols::Name(id) << "\" called with " << parameters.size()
+           << " parameters instead of " << target->getParams().size() << ". @Line: " << t.line;
+        out.Line() << "throw Error{ " << NativeWriter::Quote(ss.str()) << " };" << endl;
+    }
+    else
+    {
+        out.Line() << "try" << endl;
+        out.Open();
+
+        vector<string> values;
+        for (auto& param : parameters)
+        {
+            values.push_back(out.Expression(param));
+        }
+
+        if (values.empty())
+        {
+            out.Line() << result << " = " << out.Callee(id) << "(host, nullptr);" << endl;
+        }
+        else
+        {
+            string list;
+            for (auto& value : values) list += "std::move(" + value + "), ";
+
+            string args = result + "_args";
+            out.Line() << "Value " << args << "[] = { " << list << "};" << endl;
+            out.Line() << result << " = " << out.Callee(id) << "(host, " << args << ");" << endl;
+        }
+
+        out.Close();
+        out.Line() << "catch (const Error& e)" << endl;
+        out.Open();
+        out.Line() << "host.error(e.message);" << endl;
+        out.Close();
+    }
+
+    out.Close();
+    return result;
+}
+
+string SetFunctionValue::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(op);
+    out.Line() << out.Var(slot) << " = { true, std::move(" << value << ") };" << endl;
+    return "";
+}
+
+string ConditionalBlock::Generate(NativeWriter & out) const
+{
+    if (sBlocks.size() == 1) return out.Expression(sBlocks[0]);
+    if (pBlocks.size() == 1) return out.Expression(pBlocks[0]);
+
+    // every block is evaluated, like in Exec, a block can call functions that print
+    const OpList& blocks = sBlocks.size() > 1 ? sBlocks : pBlocks;
+    if (blocks.size() < 2) { throw OperationBugException(BUG_LOCATION); }
+
+    vector<string> values;
+    for (auto& block : blocks)
+    {
+        values.push_back(out.Expression(block));
+    }
+
+    string condition;
+    for (auto& value : values)
+    {
+        if (!condition.empty()) condition += sBlocks.size() > 1 ? " && " : " || ";
+        condition += "!" + value + ".empty()";
+    }
+
+    return out.Local("(" + condition + ") ? True() : Value()");
+}
+
+string IfStmt::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(condition);
+
+    out.Line() << "if (!" << value << ".empty())" << endl;
+    out.Open();
+    out.Statements(thanOperations);
+    out.Close();
+
+    if (!elseOperations.empty())
+    {
+        out.Line() << "else" << endl;
+        out.Open();
+        out.Statements(elseOperations);
+        out.Close();
+    }
+    return "";
+}
+
+string WhileLoop::Generate(NativeWriter & out) const
+{
+    out.Line() << "for (;;)" << endl;
+    out.Open();
+
+    string value = out.Expression(condition);
+    out.Line() << "if (" << value << ".empty()) break;" << endl;
+    out.Statements(operations);
+
+    out.Close();
+    return "";
+}
+
+string ForLoop::Generate(NativeWriter & out) const
+{
+    string dataSet = out.Expression(dataGetter);
+    string var = out.Var(slot);
+
+    out.Line() << "for (auto node : " << dataSet << ")" << endl;
+    out.Open();
+    out.Line() << var << " = { true, Value(node) };" << endl;
+    out.Statements(operations);
+    out.Line() << var << " = Var();" << endl;
+    out.Close();
+    return "";
+}
+
+string Variable::Generate(NativeWriter & out) const
+{
+    if (proven) return out.Local(out.Var(slot) + ".value");
+    return out.Local("Get(" + out.Var(slot) + ", " + NativeWriter::Quote(Symbols::Name(id)) + ", " + to_string(t.line) + ")");
+}
+
+string VariableAssignment::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(valueGetter);
+    out.Line() << out.Var(slot) << " = { true, std::move(" << value << ") };" << endl;
+    return "";
+}
+
+string NOT::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(expression);
+    return out.Local(value + ".empty() ? True() : Value()");
+}
+
+string TRUE_VAL::Generate(NativeWriter & out) const
+{
+    return out.Local("True()");
+}
+
+string FALSE_VAL::Generate(NativeWriter & out) const
+{
+    return out.Local("Value()");
+}
+
+string NullCheck::Generate(NativeWriter & out) const
+{
+    if (proven) return out.Local(out.Var(slot) + ".value.empty() ? True() : Value()");
+    return out.Local("Get(" + out.Var(slot) + ", " + NativeWriter::Quote(Symbols::Name(varId)) + ", " + to_string(t.line) + ").empty() ? True() : Value()");
+}
+
+string PRINTS::Generate(NativeWriter & out) const
+{
+    if (0 == msg.compare("endl")) out.Line() << "host.printLine();" << endl;
+    else out.Line() << "host.print(" << NativeWriter::Quote(msg) << ");" << endl;
+    return "";
+}
+
+string PRINT::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(operation);
+    out.Line() << "Print(host, " << value << ");" << endl;
+    return "";
+}
+
+string CONDITIONS_OF::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(operation);
+    return out.Local("ConditionsOf(host, " + value + ", " + NativeWriter::Quote(t.tok) + ", " + to_string(t.line) + ")");
+}
+
+string PARENT::Generate(NativeWriter & out) const
+{
+    string value = out.Expression(operation);
+    return out.Local("Parent(host, " + value + ")");
+}
+
+string GET_NODES_OF_TYPE::Generate(NativeWriter & out) const
+{
+    return out.Local("NodesOfType(host, " + NativeWriter::Quote(typeName) + ", " + NativeWriter::Quote(t.tok) + ", " + to_string(t.line) + ")");
+}
+
+string AttributeCheck::Generate(NativeWriter & out) const
+{
+    return out.Local("CheckAttribute(host, " + out.Var(slot) + ", " + NativeWriter::Quote(Symbols::Name(varId)) + ", "
+        + NativeWriter::Quote(attributeId) + ", " + NativeWriter::Quote(attribVal) + ", " + CHECK_NAMES[checkType] + ", " + to_string(t.line) + ")");
+}
+
+string CompareAttribute::Generate(NativeWriter & out) const
+{
+    return out.Local("CompareAttributes(host, "
+        + out.Var(slot1) + ", " + NativeWriter::Quote(Symbols::Name(varId1)) + ", " + NativeWriter::Quote(attributeId1) + ", "
+        + NativeWriter::Quote(prefix1) + ", " + NativeWriter::Quote(postfix1) + ", "
+        + out.Var(slot2) + ", " + NativeWriter::Quote(Symbols::Name(varId2)) + ", " + NativeWriter::Quote(attributeId2) + ", "
+        + NativeWriter::Quote(prefix2) + ", " + NativeWriter::Quote(postfix2) + ", "
+        + CHECK_NAMES[checkType] + ", " + to_string(t.line) + ")");
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "interpreter.h"
+#include "operations.h"
+#include "symbols.h"
+
+// C++ source of a native rule set
+// ===============================
+// Every function of the table becomes a C++ function over NativeRules (include/native_rules.h) that
+// calls IAdapter directly. Variables are the frame slots of the function (frames.h) in an array; an
+// operation writes its value to a new local and Generate returns the name of it. Calls are bound to
+// the functions of the table. The output depends only on the table and the file hashes, so the same
+// rule set always gives the same source.
+class NativeWriter
+{
+private:
+    const FunctionTable& functions;
+    std::map<std::string_view, size_t> index;   // position of every function in the table
+    std::ostringstream code;                    // body of the current function
+    int indent;
+    int locals;
+    unsigned int slots;                         // frame size of the current function
+
+private:
+    void WriteFunction(const Function& function, std::ostream& out);
+
+public:
+    NativeWriter(const FunctionTable& functions);
+
+    std::string Source(const std::vector<uint64_t>& fileHashes);
+
+    std::ostream& Line();                       // starts a line of the current block
+    void Open();
+    void Close();
+    std::string Local(const std::string& initializer = "");  // declares a Value, returns its name
+    std::string Var(unsigned int slot);         // a variable of the current function
+    std::string Callee(SymbolId id) const;      // C++ name of a function, empty if the table has none
+    const Function* Find(SymbolId id) const;     // the callee of the table, null if there is none
+
+    std::string Expression(const OP_PTR& op);   // name of the Value
+    void Statements(const OpList& ops);
+
+    static std::string Quote(std::string_view text);    // C++ string literal
+};
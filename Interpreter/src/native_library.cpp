@@ -0,0 +1,82 @@
+#include "native_library.h"
+#include "trace.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+    void Print(const string& text)
+    {
+        YELLOW(text);
+        _TRACE_(text << endl);
+    }
+
+    void PrintLine()
+    {
+        cout << std::endl;
+    }
+
+    void Error(const string& message)
+    {
+        RED("RUNTIME ERROR: " << message);
+        _TRACE_("        RUNTIME ERROR: " << message << endl);
+    }
+}
+
+
+
+NativeLibrary::NativeLibrary(string libraryPath, HMODULE handle, const NativeRules::RuleSet* ruleSet)
+    : path(libraryPath), module(handle), rules(ruleSet)
+{
+}
+
+NativeLibrary::~NativeLibrary()
+{
+    FreeLibrary(module);
+}
+
+unique_ptr<NativeLibrary> NativeLibrary::Open(const string& path, string& error)
+{
+    HMODULE module = LoadLibraryA(path.c_str());
+    if (!module)
+    {
+        error = "cannot load \"" + path + "\"";
+        return nullptr;
+    }
+
+    auto getRuleSet = (NativeRules::GetRuleSetFn)GetProcAddress(module, "GetNativeRuleSet");
+    const NativeRules::RuleSet* rules = getRuleSet ? getRuleSet() : nullptr;
+
+    if (!rules || rules->version != NATIVE_RULES_VERSION)
+    {
+        FreeLibrary(module);
+        error = "\"" + path + "\" is not a native rule set of this interpreter version";
+        return nullptr;
+    }
+
+    return unique_ptr<NativeLibrary>(new NativeLibrary(path, module, rules));
+}
+
+bool NativeLibrary::Matches(const vector<uint64_t>& fileHashes) const
+{
+    return fileHashes.size() == rules->fileCount && equal(fileHashes.begin(), fileHashes.end(), rules->fileHashes);
+}
+
+int NativeLibrary::Find(string_view function) const
+{
+    auto begin = rules->functions;
+    auto end = rules->functions + rules->functionCount;
+    auto it = lower_bound(begin, end, function, [](const char* name, string_view f) { return string_view(name) < f; });
+
+    return (it != end && string_view(*it) == function) ? (int)(it - begin) : -1;
+}
+
+bool NativeLibrary::Execute(IAdapter* adapter, pmr::memory_resource* memory, unsigned int function, bool& result, string& error) const
+{
+    NativeRules::Host host = { adapter, memory, Print, PrintLine, Error };
+    return rules->execute(host, function, result, error);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <windows.h>
+#include "../include/native_rules.h"
+
+// A rule set compiled by Interpreter::BuildNative, loaded with LoadLibrary
+class NativeLibrary
+{
+private:
+    std::string path;
+    HMODULE module;
+    const NativeRules::RuleSet* rules;
+
+private:
+    NativeLibrary(std::string path, HMODULE module, const NativeRules::RuleSet* rules);
+
+public:
+    ~NativeLibrary();
+
+    // null if the library is missing or was not built for this interpreter, the reason is in 'error'
+    static std::unique_ptr<NativeLibrary> Open(const std::string& path, std::string& error);
+
+    const std::string& Path() const { return path; }
+    bool Matches(const std::vector<uint64_t>& fileHashes) const;   // built from these rule files
+    int Find(std::string_view function) const;  // -1 if the library has no function with that name
+
+    // runs a function without parameters, false if it ended with a runtime error (in 'error')
+    bool Execute(IAdapter* adapter, std::pmr::memory_resource* memory, unsigned int function, bool& result, std::string& error) const;
+};
@@ -1,7 +1,6 @@
 #include "operation.h"
-#include <iostream>
-Operation::Operation(Token tok)
+
+Operation::Operation(const TokenInfo& tok)
     : t(tok)
 {
-    std::cout << ".";
 }
\ No newline at end of file
@@ -1,28 +1,59 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include "token.h"
+#include "operation_exceptions.h"
 #include "variable_set.h"
+#include "closures.h"
 
 class Interpreter;
-struct Token;
+class ImageWriter;
+class BytecodeWriter;
+class NativeWriter;
+class FrameResolver;
+struct TokenInfo;
 
 class Operation
 {
 public:
 
-    virtual void Exec(Interpreter & interpreter) = 0;
+    virtual RuntimeError Exec(Interpreter & interpreter) = 0;    // the value is left in the return slot of the interpreter
+    virtual void Serialize(ImageWriter & out) const = 0;   // writes the operation to a rule image (rule_cache.cpp)
+    virtual void Compile(BytecodeWriter & out) const = 0;  // emits the operation for the bytecode engine (bytecode.cpp)
+    virtual Closure Bind() const = 0;                      // the operation as a callable for the closure engine (closures.cpp)
+    virtual std::string Generate(NativeWriter & out) const = 0;    // the operation as C++ source, returns the local with its value (native_codegen.cpp)
+    virtual void Resolve(FrameResolver & out) = 0;                 // assigns the frame slots of its variables (frames.cpp)
 
 protected:
 
-    Operation(Token idTok);
+    Operation(const TokenInfo& idTok);     // a location in the arena of the function (arena.h), a function keeps its own
 
 public:
 
-    Token t;
+    const TokenInfo& t;
 };
 
-typedef std::shared_ptr<Operation> OP_PTR;
+typedef Operation* OP_PTR;      // owned by the OperationArena of its function
+
+// Child operations of an operation, an array in the arena of the function
+class OpList
+{
+private:
+    OP_PTR const* items;
+    uint32_t count;
+
+public:
+    OpList() : items(nullptr), count(0) {}
+    OpList(OP_PTR const* ops, uint32_t size) : items(ops), count(size) {}
+
+    OP_PTR const* begin() const { return items; }
+    OP_PTR const* end() const { return items + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    OP_PTR operator[](size_t i) const { return items[i]; }
+};
 
 #define __TRACE_EXEC__ _TRACE_("        RUN   >>>  " __FUNCTION__ << "@" << t.line << interpreter.stack.ToStr(interpreter) << endl);
 #define __TRACE_CONSTRUCT__ _TRACE_("        NEW   >>>  " << __FUNCTION__ << endl);
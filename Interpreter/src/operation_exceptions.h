@@ -1,23 +1,52 @@
 #pragma once
 
 #include <exception>
+#include <memory>
 #include <string>
 #include <sstream>
+#include <utility>
 
-
-class RuntimeException : public std::exception
+// Runtime errors
+// ==============
+// The engines return a runtime error instead of throwing it, rules that run into a missing
+// attribute or an undefined variable on most nodes would otherwise pay for unwinding every time.
+// The error goes back up to the innermost function call in progress, which prints it and returns
+// an empty value. No error is a null pointer, so passing the status up costs a test per operation.
+class RuntimeError
 {
 private:
-    std::string msg;
+    std::unique_ptr<std::string> msg;
 public:
-    RuntimeException(std::string message) : msg(message) {};
+    RuntimeError() = default;
+    explicit RuntimeError(std::string message) : msg(std::make_unique<std::string>(std::move(message))) {};
 
-    const char * what() const throw ()
+    explicit operator bool() const { return msg != nullptr; }   // true for an error
+
+    const char * what() const
     {
-        return msg.c_str();
+        return msg ? msg->c_str() : "";
     }
 };
 
+// value of an expression, or the runtime error that ended its evaluation
+template<class T>
+class Expected
+{
+private:
+    T val;
+    RuntimeError err;
+public:
+    Expected(T value) : val(std::move(value)) {};
+    Expected(RuntimeError error) : err(std::move(error)) {};
+
+    bool Failed() const { return static_cast<bool>(err); }
+    T& Value() { return val; }
+    RuntimeError& Error() { return err; }
+};
+
+
+// location of an OperationBugException, e.g. "Compile:142"
+#define BUG_LOCATION (std::string(__FUNCTION__) + ":" + std::to_string(__LINE__))
 
 class OperationBugException : public std::exception
 {
@@ -6,23 +6,25 @@
 #include "utils.h"
 #include "operation_exceptions.h"
 #include "operation.h"
+#include "parser.h"
 #include "../include/script_interpreter.h"
 
 using namespace std;
 
 
-IfStmt::IfStmt(OP_PTR cond, vector<OP_PTR> thanOps, vector<OP_PTR> elseOps, Token idTok)
+IfStmt::IfStmt(OP_PTR cond, OpList thanOps, OpList elseOps, const TokenInfo& idTok)
     : condition(cond), thanOperations(thanOps), elseOperations(elseOps), Operation(idTok)
 {   
     __TRACE_CONSTRUCT__; 
     if (!condition) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void IfStmt::Exec(Interpreter & interpreter)
+RuntimeError IfStmt::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
     
-    condition->Exec(interpreter);
+    RuntimeError error = condition->Exec(interpreter);
+    if (error) return error;
     VarValue val = interpreter.stack.PopReturn();
 
     if (!val.empty()) // evaluate the boolean value of condition statement .. empty vector means false
@@ -30,7 +32,8 @@ void IfStmt::Exec(Interpreter & interpreter)
         for (auto op : thanOperations)
         {
             if (!op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
-            op->Exec(interpreter);
+            error = op->Exec(interpreter);
+            if (error) return error;
         }
     }
     else
@@ -38,14 +41,16 @@ void IfStmt::Exec(Interpreter & interpreter)
         for (auto op : elseOperations)
         {
             if (!op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
-            op->Exec(interpreter);
+            error = op->Exec(interpreter);
+            if (error) return error;
         }
     }
+    return RuntimeError();
 }
 
 
 
-ConditionalBlock::ConditionalBlock(Token idTok) // for atomic elements
+ConditionalBlock::ConditionalBlock(const TokenInfo& idTok) // for atomic elements
     : Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
@@ -53,7 +58,7 @@ ConditionalBlock::ConditionalBlock(Token idTok) // for atomic elements
 }
 
 
-ConditionalBlock::ConditionalBlock(vector<OP_PTR> SB, vector<OP_PTR> PB, Token idTok)
+ConditionalBlock::ConditionalBlock(OpList SB, OpList PB, const TokenInfo& idTok)
     : sBlocks(SB), pBlocks(PB), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
@@ -92,20 +97,23 @@ ConditionalBlock::ConditionalBlock(vector<OP_PTR> SB, vector<OP_PTR> PB, Token i
     _TRACE_("        NEW_BLOCK >>> SB: " << sBlocks.size() << " PB: " << pBlocks.size() << endl);
 }
 
-void ConditionalBlock::Exec(Interpreter & interpreter)
+RuntimeError ConditionalBlock::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
     VarValue retVal;
+    RuntimeError error;
 
     if (sBlocks.size() == 1)
     {
-        sBlocks[0]->Exec(interpreter);
+        error = sBlocks[0]->Exec(interpreter);
+        if (error) return error;
         retVal = interpreter.stack.PopReturn();
     }
     else if (pBlocks.size() == 1)
     {
-        pBlocks[0]->Exec(interpreter);
+        error = pBlocks[0]->Exec(interpreter);
+        if (error) return error;
         retVal = interpreter.stack.PopReturn();
     }
     else if (sBlocks.size() > 1)
@@ -113,89 +121,96 @@ void ConditionalBlock::Exec(Interpreter & interpreter)
         bool result = true;
         for (auto block : sBlocks)
         {
-            block->Exec(interpreter);
+            error = block->Exec(interpreter);
+            if (error) return error;
             VarValue ret = interpreter.stack.PopReturn();
             result = result && (ret.size() > 0);
         }
-        if (result) { retVal.push_back(0); } // return non empty vector => means true
+        if (result) { retVal = VarValue::True(); } // return non empty value => means true
     }
     else if (pBlocks.size() > 1)
     {                           // here we evaluate a condition block constructed from ORs (pBlocks)
         bool result = false;
         for (auto block : pBlocks)
         {
-            block->Exec(interpreter);
+            error = block->Exec(interpreter);
+            if (error) return error;
             VarValue ret = interpreter.stack.PopReturn();
             result = result || (ret.size() > 0);
         }
-        if (result) { retVal.push_back(0); } // return non empty vector => means true
+        if (result) { retVal = VarValue::True(); } // return non empty value => means true
     }
     else { throw OperationBugException(__FUNCTION__ + __LINE__); }
 
     interpreter.stack.PushReturn(retVal);
+    return RuntimeError();
 }
 
 
 
-WhileLoop::WhileLoop(OP_PTR cond, vector<OP_PTR> ops, Token idTok)
+WhileLoop::WhileLoop(OP_PTR cond, OpList ops, const TokenInfo& idTok)
     : condition(cond), operations(ops), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!condition) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void WhileLoop::Exec(Interpreter & interpreter)
+RuntimeError WhileLoop::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    condition->Exec(interpreter);
+    RuntimeError error = condition->Exec(interpreter);
+    if (error) return error;
     VarValue val = interpreter.stack.PopReturn();
     while (!val.empty()) // evaluate the boolean value of condition statement .. empty vector means false
     {
         for (auto op : operations)
         {
             if (!op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
-            op->Exec(interpreter);
+            error = op->Exec(interpreter);
+            if (error) return error;
         }
 
-        condition->Exec(interpreter);
+        error = condition->Exec(interpreter);
+        if (error) return error;
         val = interpreter.stack.PopReturn();
     }
+    return RuntimeError();
 }
 
 
 
 
 
-ForLoop::ForLoop(std::string i, OP_PTR d, vector<OP_PTR> o, Token idTok)
-    : id(i), dataGetter(d), operations(o), Operation(idTok)
+ForLoop::ForLoop(SymbolId i, OP_PTR d, OpList o, const TokenInfo& idTok)
+    : id(i), slot(0), dataGetter(d), operations(o), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!dataGetter) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void ForLoop::Exec(Interpreter & interpreter)
+RuntimeError ForLoop::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__
 
-    dataGetter->Exec(interpreter);
+    RuntimeError error = dataGetter->Exec(interpreter);
+    if (error) return error;
     VarValue dataSet = interpreter.stack.PopReturn();
 
     for (auto obj : dataSet)
     {
-        VarValue loop_variable;
-        loop_variable.push_back(obj);
-
-        interpreter.stack.Add(id, loop_variable);
+        interpreter.stack.Add(slot, VarValue(obj));
 
         for (auto op : operations)
         {
             if (!op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
-            op->Exec(interpreter);
+            error = op->Exec(interpreter);
+            if (error) return error;
         }
 
-        interpreter.stack.Remove(id);
+        interpreter.stack.Remove(slot);
     }
+    return RuntimeError();
 }
 
 
@@ -204,265 +219,343 @@ void ForLoop::Exec(Interpreter & interpreter)
 
 
 
-Function::Function(string functionId, vector<OP_PTR> ops, vector<string> params, Token idTok)
-    : id(functionId), operations(ops), parameters(params), Operation(idTok)
+Function::Function(SymbolId functionId, OpList ops, vector<SymbolId> params, const TokenInfo& idTok, SOURCE_PTR src, unique_ptr<OperationArena> bodyArena)
+    : id(functionId), parameters(params), source(src), body({ 0, 0, 0 }), location(idTok), arena(move(bodyArena)), operations(ops), parsed(true), compiled(false), bound(false), isVolatile(false), Operation(location)
+{
+    __TRACE_CONSTRUCT__
+    LayOut();
+}
+
+Function::Function(SymbolId functionId, vector<SymbolId> params, SourceRange bodyRange, const TokenInfo& idTok, SOURCE_PTR src)
+    : id(functionId), parameters(params), source(src), body(bodyRange), location(idTok), parsed(false), compiled(false), bound(false), isVolatile(false), Operation(location)
 {
     __TRACE_CONSTRUCT__
 }
 
-void Function::Exec(Interpreter & interpreter)
+string Function::Validate() const
+{
+    return Parse() ? parseError : string();
+}
+
+RuntimeError Function::Parse() const
+{
+    if (!parsed.load(memory_order_acquire))
+    {
+        lock_guard<mutex> lock(parseMutex);
+
+        if (!parsed.load(memory_order_relaxed))
+        {
+            _TRACE_("        PARSING BODY OF: " << getId() << endl);
+
+            LangParser parser;
+            arena = make_unique<OperationArena>();
+            operations = parser.parseBody(source, body, *arena, parseError);
+            if (parseError.empty()) LayOut();
+            parsed.store(true, memory_order_release);
+        }
+    }
+
+    return parseError.empty() ? RuntimeError() : RuntimeError(parseError);
+}
+
+RuntimeError Function::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
+
+    RuntimeError error = Parse();
+    if (error) return error;
     
-    interpreter.stack.Add(id, VarValue()); // add variable for function return value
+    interpreter.stack.Add(frame.result, VarValue()); // add variable for function return value
 
     for (auto op = operations.begin(); op != operations.end(); op++)
     {
         if (!*op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
-        (*op)->Exec(interpreter);
+        error = (*op)->Exec(interpreter);
+        if (error) return error;
     }
     
-    interpreter.stack.PushReturn(interpreter.stack.GetValue(id)); // set return value 
+    interpreter.stack.PushReturn(interpreter.stack.TakeValue(frame.result)); // set return value 
+    return RuntimeError();
+}
+
+void Function::ShiftLines(int delta)
+{
+    location.line += delta;
+    body.line += delta;
+
+    if (arena) arena->ShiftLines(delta);
+    for (auto& call : frame.calls) call.line += delta;
 }
 
 
 
 
-SetFunctionValue::SetFunctionValue(std::string id, OP_PTR operation, Token idTok)
-    : functionId(id), op(operation), Operation(idTok)
+SetFunctionValue::SetFunctionValue(SymbolId id, OP_PTR operation, const TokenInfo& idTok)
+    : functionId(id), slot(0), op(operation), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!op) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void SetFunctionValue::Exec(Interpreter & interpreter)
+RuntimeError SetFunctionValue::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    op->Exec(interpreter);
+    RuntimeError error = op->Exec(interpreter);
+    if (error) return error;
     
-    interpreter.stack.Add(functionId, interpreter.stack.PopReturn());
+    interpreter.stack.Add(slot, interpreter.stack.PopReturn());
+    return RuntimeError();
 }
 
 
 
 
 
-FunctionCall::FunctionCall(std::string funcId, vector<OP_PTR> params, Token idTok)
+FunctionCall::FunctionCall(SymbolId funcId, OpList params, const TokenInfo& idTok)
     : id(funcId), parameters(params), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void FunctionCall::Exec(Interpreter & interpreter)
+RuntimeError FunctionCall::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-     FUNC_PTR func = interpreter.getFunction(id);
+     Function* func = interpreter.Callee(id);
 
      if (!func)
      {
          stringstream ss;
-         ss << "Function with name \"" << id << "\" not defined! @Line: " << t.line;
-         throw RuntimeException(ss.str().c_str());
+         ss << "Function with name \"" << Symbols::Name(id) << "\" not defined! @Line: " << t.line;
+         return RuntimeError(ss.str());
      }
 
-     auto targetParams = func->getParams();
+     const auto& targetParams = func->getParams();
 
      if (parameters.size() != targetParams.size())
      {
          stringstream ss;
-         ss << "Function with name \"" << id << "\" called with " << parameters.size()
+         ss << "Function with name \"" << Symbols::Name(id) << "\" called with " << parameters.size()
             << " parameters instead of " << targetParams.size() << ". @Line: " << t.line;
-         throw RuntimeException(ss.str().c_str());
+         return RuntimeError(ss.str());
      }
 
-     try
+     RuntimeError error = func->Parse();    // a body that does not parse fails the call before its arguments are evaluated
+
+     if (!error)
      {
-         vector<VarValue> paramValues;
+         const FrameLayout& frame = func->Frame();
+         CallFrame callee(interpreter.frames, frame);
 
-         for (size_t i = 0; i < parameters.size(); i++)
+         for (size_t i = 0; i < parameters.size() && !error; i++)
          {
-             parameters[i]->Exec(interpreter); // evalueate param expression
-             paramValues.push_back(interpreter.stack.PopReturn());
+             error = parameters[i]->Exec(interpreter); // evalueate param expression in the callers frame
+             if (!error) callee.variables.Add(frame.params[i], interpreter.stack.PopReturn());
          }
 
-         interpreter.PushStack(); // save callers stack
-         interpreter.stack.Clear();
-         
-         for (size_t i = 0; i < parameters.size(); i++) 
-         {   
-             interpreter.stack.Add(targetParams[i], paramValues[i]); // add fn parameters with propper name&value
+         // a pure function called with the same nodes before returns the value of that call
+         MemoKey key(*func);
+         bool memoized = !error && interpreter.Memoized(id);
+
+         for (size_t i = 0; i < parameters.size() && memoized; i++)
+         {
+             memoized = key.Add(callee.variables.GetValue(frame.params[i]));
          }
 
-         func->Exec(interpreter);
+         const VarValue* known = memoized ? interpreter.memo.Find(key) : nullptr;
+         if (known)
+         {
+             interpreter.stack.PushReturn(*known);
+             return error;
+         }
 
-         VarValue retVal = interpreter.stack.PopReturn(); // save return value 
-         interpreter.PopStack(); // restore callers stack
-         interpreter.stack.PushReturn(retVal);
-     }
-     catch (const RuntimeException& e)
-     {
-         interpreter.PopStack(); // restore callers stack
-         interpreter.stack.PushReturn(VarValue());
-         RED("RUNTIME ERROR: " << e.what());
-         _TRACE_("        RUNTIME ERROR: " << e.what() << endl);
+         if (!error)
+         {
+             size_t handled = interpreter.memo.Errors();
+
+             VariableSet caller = interpreter.stack; // save callers stack
+             interpreter.stack = callee.variables;
+
+             error = func->Exec(interpreter);
+
+             VarValue retVal = interpreter.stack.PopReturn(); // save return value 
+             interpreter.stack = caller; // restore callers stack
+
+             if (!error)
+             {
+                 if (memoized && interpreter.memo.Errors() == handled) interpreter.memo.Store(key, retVal);
+
+                 interpreter.stack.PushReturn(move(retVal));
+                 return error;
+             }
+         }
      }
+
+     interpreter.memo.Handled();
+     interpreter.stack.PushReturn(VarValue());
+     RED("RUNTIME ERROR: " << error.what());
+     _TRACE_("        RUNTIME ERROR: " << error.what() << endl);
+     return RuntimeError();     // handled, the call returns nothing
 }
 
 
 
-Variable::Variable(std::string varId, Token idTok)
-    : id(varId), Operation(idTok)
+Variable::Variable(SymbolId varId, const TokenInfo& idTok)
+    : id(varId), slot(0), proven(false), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void Variable::Exec(Interpreter & interpreter)
+RuntimeError Variable::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
     
-    if (!interpreter.stack.Exists(id))
+    if (!proven && !interpreter.stack.Exists(slot))
     {
         stringstream ss;
-        ss << "Undefined variable: " << id << " @line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Undefined variable: " << Symbols::Name(id) << " @line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
-    VarValue val = interpreter.stack.GetValue(id); // find value of variable
+    _TRACE_("        ID: " << Symbols::Name(id) << endl);
 
-    _TRACE_("        ID: " << id << endl);
-
-    interpreter.stack.PushReturn(val);  /// return value
+    interpreter.stack.PushReturn(interpreter.stack.GetValue(slot));  /// return value, shares a node set
+    return RuntimeError();
 }
 
 
 
 
-VariableAssignment::VariableAssignment(string varId, OP_PTR val, Token idTok)
-    : id(varId), valueGetter(val), Operation(idTok)
+VariableAssignment::VariableAssignment(SymbolId varId, OP_PTR val, const TokenInfo& idTok)
+    : id(varId), slot(0), valueGetter(val), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!valueGetter) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void VariableAssignment::Exec(Interpreter & interpreter)
+RuntimeError VariableAssignment::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    _TRACE_("        ID: " << id << endl);
+    _TRACE_("        ID: " << Symbols::Name(id) << endl);
 
-    valueGetter->Exec(interpreter);
-    interpreter.stack.Add(id, interpreter.stack.PopReturn());
+    RuntimeError error = valueGetter->Exec(interpreter);
+    if (error) return error;
+    interpreter.stack.Add(slot, interpreter.stack.PopReturn());
+    return RuntimeError();
 }
 
 
 
 
 
-NOT::NOT(OP_PTR expr, Token idTok)
+NOT::NOT(OP_PTR expr, const TokenInfo& idTok)
     : expression(expr), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!expression) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void NOT::Exec(Interpreter & interpreter)
+RuntimeError NOT::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    expression->Exec(interpreter);
+    RuntimeError error = expression->Exec(interpreter);
+    if (error) return error;
     VarValue val = interpreter.stack.PopReturn();
 
     VarValue result;
 
     if (val.empty()) // if expression is false (empty vector) , we return true (non empty vector)
     {
-        result.push_back(0);
+        result = VarValue::True();
     }
 
     interpreter.stack.PushReturn(result);
+    return RuntimeError();
 }
 
 
 
-TRUE_VAL::TRUE_VAL(Token idTok)
+TRUE_VAL::TRUE_VAL(const TokenInfo& idTok)
     : Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void TRUE_VAL::Exec(Interpreter & interpreter)
+RuntimeError TRUE_VAL::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__
 
-    VarValue val;
-
-    val.push_back(0); // non empty vector means true, so we add an element
+    VarValue val = VarValue::True(); // non empty value means true, a single null node
 
     interpreter.stack.PushReturn(val);  /// return value
+    return RuntimeError();
 }
 
 
 
 
 
-FALSE_VAL::FALSE_VAL(Token idTok)
+FALSE_VAL::FALSE_VAL(const TokenInfo& idTok)
     : Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void FALSE_VAL::Exec(Interpreter & interpreter)
+RuntimeError FALSE_VAL::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__
 
     VarValue val;
 
     interpreter.stack.PushReturn(val);  /// return value
+    return RuntimeError();
 }
 
 
 
 
 
-NullCheck::NullCheck(string variableId, Token idTok)
-    : varId(variableId), Operation(idTok)
+NullCheck::NullCheck(SymbolId variableId, const TokenInfo& idTok)
+    : varId(variableId), slot(0), proven(false), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void NullCheck::Exec(Interpreter & interpreter)
+RuntimeError NullCheck::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    if (!interpreter.stack.Exists(varId))
+    if (!proven && !interpreter.stack.Exists(slot))
     {
         stringstream ss;
-        ss << "Undefined variable: " << varId << " @line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Undefined variable: " << Symbols::Name(varId) << " @line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
-    VarValue val = interpreter.stack.GetValue(varId);
+    const VarValue& val = interpreter.stack.GetValue(slot);
 
     VarValue result;
     if (val.empty())
     {
-        result.push_back(0); // return non empty => because variable value was 0
+        result = VarValue::True(); // return non empty => because variable value was 0
     }
 
     interpreter.stack.PushReturn(result);
+    return RuntimeError();
 }
 
 
 
-PRINTS::PRINTS(std::string message, Token idTok)
+PRINTS::PRINTS(std::string message, const TokenInfo& idTok)
     : msg(message), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void PRINTS::Exec(Interpreter & interpreter)
+RuntimeError PRINTS::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__
 
@@ -477,22 +570,24 @@ void PRINTS::Exec(Interpreter & interpreter)
             YELLOW(msg);
         }
 
+    return RuntimeError();
 }
 
 
 
-PRINT::PRINT(OP_PTR op, Token idTok)
+PRINT::PRINT(OP_PTR op, const TokenInfo& idTok)
     : operation(op), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!operation) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 };
 
-void PRINT::Exec(Interpreter & interpreter)
+RuntimeError PRINT::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__
 
-        operation->Exec(interpreter);
+    RuntimeError error = operation->Exec(interpreter);
+    if (error) return error;
     VarValue nodes = interpreter.stack.PopReturn();
     for (auto node : nodes)
     {
@@ -504,46 +599,49 @@ void PRINT::Exec(Interpreter & interpreter)
             _TRACE_(attribs->ToString() << endl);
         }
     }
+    return RuntimeError();
 }
 
 
 
 
 
-CONDITIONS_OF::CONDITIONS_OF(OP_PTR op, Token idTok)
+CONDITIONS_OF::CONDITIONS_OF(OP_PTR op, const TokenInfo& idTok)
     : operation(op), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
     if (!operation) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void CONDITIONS_OF::Exec(Interpreter & interpreter)
+RuntimeError CONDITIONS_OF::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    operation->Exec(interpreter);
+    RuntimeError error = operation->Exec(interpreter);
+    if (error) return error;
     VarValue val = interpreter.stack.PopReturn();
 
     if (val.empty())
     {
         stringstream ss;
         ss << t.tok << " called with expression which returned nothing. @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        return RuntimeError(ss.str());
     }
 
     if (0 == val[0])
     {
         stringstream ss;
         ss << "Operation " << t.tok << " parameter is NULL pointer. @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        return RuntimeError(ss.str());
     }
 
-    interpreter.stack.PushReturn(interpreter.adapter->GetGeogConds(val[0]));
+    interpreter.stack.PushReturn(VarValue(interpreter.adapter->GetGeogConds(val[0]), &interpreter.memory));
+    return RuntimeError();
 }
 
 
 
-PARENT::PARENT(OP_PTR op, Token idTok)
+PARENT::PARENT(OP_PTR op, const TokenInfo& idTok)
     : operation(op), Operation(idTok)
 {
     __TRACE_CONSTRUCT__;
@@ -551,32 +649,34 @@ PARENT::PARENT(OP_PTR op, Token idTok)
     if (!operation) { throw OperationBugException(__FUNCTION__ + __LINE__); }
 }
 
-void PARENT::Exec(Interpreter & interpreter)
+RuntimeError PARENT::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    operation->Exec(interpreter);
+    RuntimeError error = operation->Exec(interpreter);
+    if (error) return error;
     VarValue val = interpreter.stack.PopReturn();
 
     VarValue parents;
     
     if (!val.empty())
     {
-        parents = interpreter.adapter->GetParentsForNode(val[0]);
+        parents = VarValue(interpreter.adapter->GetParentsForNode(val[0]), &interpreter.memory);
     }
 
     interpreter.stack.PushReturn(parents);
+    return RuntimeError();
 }
 
 
 
-GET_NODES_OF_TYPE::GET_NODES_OF_TYPE(string nodeTypeName, Token idTok)
+GET_NODES_OF_TYPE::GET_NODES_OF_TYPE(string nodeTypeName, const TokenInfo& idTok)
     : typeName(nodeTypeName), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void GET_NODES_OF_TYPE::Exec(Interpreter & interpreter)
+RuntimeError GET_NODES_OF_TYPE::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
@@ -584,14 +684,15 @@ void GET_NODES_OF_TYPE::Exec(Interpreter & interpreter)
     {
         stringstream ss;
         ss << "Parameter \"" << typeName << "\" of " << t.tok << " is not a known Node Type. @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        return RuntimeError(ss.str());
     }
 
-    interpreter.stack.PushReturn(interpreter.adapter->GetAllNodesOfType(typeName, 0));
+    interpreter.stack.PushReturn(VarValue(interpreter.adapter->GetAllNodesOfType(typeName, 0), &interpreter.memory));
+    return RuntimeError();
 }
 
 
-int AttributeCheck::GetValue(string val)
+Expected<int> AttributeCheck::GetValue(string val) const
 {   
     int nval = 0;
     try {
@@ -600,69 +701,88 @@ int AttributeCheck::GetValue(string val)
     catch (invalid_argument&)
     {
         stringstream ss;
-        ss << "Cannot compare value of " << varId << "." << attributeId << ":" << val << " with a number! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Cannot compare value of " << Symbols::Name(varId) << "." << attributeId << ":" << val << " with a number! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
     return nval;
 }
 
-AttributeCheck::AttributeCheck(string variableId, string attributeName, string attributeValue, CheckType chkType, Token idTok)
-    : varId(variableId), attributeId(attributeName), attribVal(attributeValue), checkType(chkType), Operation(idTok)
+AttributeCheck::AttributeCheck(SymbolId variableId, string attributeName, string_view attributeValue, CheckType chkType, const TokenInfo& idTok)
+    : varId(variableId), slot(0), proven(false), attributeId(attributeName), attribVal(attributeValue), checkType(chkType), Operation(idTok)
 {
     __TRACE_CONSTRUCT__
 }
 
-void AttributeCheck::Exec(Interpreter & interpreter)
+RuntimeError AttributeCheck::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
-    if (!interpreter.stack.Exists(varId))
+    Expected<VarValue> result = Evaluate(interpreter.stack, interpreter.adapter);
+    if (result.Failed()) return move(result.Error());
+
+    interpreter.stack.PushReturn(move(result.Value()));
+    return RuntimeError();
+}
+
+Expected<VarValue> AttributeCheck::Evaluate(const VariableSet& variables, IAdapter* adapter, unsigned int base) const
+{
+    unsigned int at = base + slot;     // slot in the frame
+
+    if (!proven && !variables.Exists(at))
     {
         stringstream ss;
-        ss << "Undefined variable: " << varId << " @line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Undefined variable: " << Symbols::Name(varId) << " @line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
-    VarValue val = interpreter.stack.GetValue(varId);
+    const VarValue& val = variables.GetValue(at);
 
     if (val.empty())
     {
         stringstream ss;
-        ss << "Variable named \"" << varId << "\" has empty value! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId) << "\" has empty value! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
-    ATTR_PTR attributes = interpreter.adapter->GetAttributesOf(val[0]);
+    ATTR_PTR attributes = adapter->GetAttributesOf(val[0]);
 
     if (0 == attributes)
     {
         stringstream ss;
-        ss << "Variable named \"" << varId << "\" has no attributes! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId) << "\" has no attributes! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
     if (!attributes->Exists(attributeId))
     {
         stringstream ss;
-        ss << "Variable named \"" << varId << "\" has no attribute named \"" << attributeId << "\" ! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId) << "\" has no attribute named \"" << attributeId << "\" ! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
     VarValue result;
     string currentVal = attributes->GetValueOf(attributeId);
 
+    int number = 0;     // of the attribute, for the comparisons
+    if (checkType == CheckType::LT || checkType == CheckType::GT || checkType == CheckType::LE || checkType == CheckType::GE)
+    {
+        Expected<int> value = GetValue(currentVal);
+        if (value.Failed()) return move(value.Error());
+        number = value.Value();
+    }
+
     switch (checkType)
     {
     case CheckType::EQUAL:
         if (currentVal == attribVal)
         {
-            result.push_back(0); 
+            result = VarValue::True(); 
         }
         break;
     case CheckType::STARTS_WITH:
         if (currentVal.compare(0,attribVal.length(), attribVal)==0)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::ENDS_WITH:
@@ -670,57 +790,57 @@ void AttributeCheck::Exec(Interpreter & interpreter)
         {
             if (currentVal.substr(currentVal.length() - attribVal.length(), attribVal.length()) == attribVal)
             {
-                result.push_back(0);
+                result = VarValue::True();
             }
         }
         break;
     case CheckType::CONTAINS:
         if (currentVal.find(attribVal) != string::npos)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::LT:
-        if (GetValue(currentVal) < stoi(attribVal))
+        if (number < stoi(string(attribVal)))
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::GT:
-        if (GetValue(currentVal) > stoi(attribVal))
+        if (number > stoi(string(attribVal)))
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::LE:
-        if (GetValue(currentVal) <= stoi(attribVal))
+        if (number <= stoi(string(attribVal)))
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::GE:
-        if (GetValue(currentVal) >= stoi(attribVal))
+        if (number >= stoi(string(attribVal)))
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     default:
         break;
     }
 
-    interpreter.stack.PushReturn(result);
+    return result;
 }
 
 
 
 
 CompareAttribute::CompareAttribute(
-    std::string variableId1, string attributeName1, string pref1, string postf1,
-    std::string variableId2, string attributeName2, string pref2, string postf2,
-    CheckType chType, Token idTok)
+    SymbolId variableId1, string attributeName1, string_view pref1, string_view postf1,
+    SymbolId variableId2, string attributeName2, string_view pref2, string_view postf2,
+    CheckType chType, const TokenInfo& idTok)
     :
-    varId1(variableId1), attributeId1(attributeName1),
-    varId2(variableId2), attributeId2(attributeName2),
+    varId1(variableId1), slot1(0), proven1(false), attributeId1(attributeName1),
+    varId2(variableId2), slot2(0), proven2(false), attributeId2(attributeName2),
     prefix1(pref1), postfix1(postf1),
     prefix2(pref2), postfix2(postf2),
     checkType(chType), Operation(idTok)
@@ -728,13 +848,13 @@ CompareAttribute::CompareAttribute(
     __TRACE_CONSTRUCT__
 }
 
-int CompareAttribute::GetValueL(string val) const
+Expected<int> CompareAttribute::GetValueL(string val) const
 {
     if (!isNumber(val))
     {
         stringstream ss;
-        ss << "Value of " << varId1 << "." << attributeId1 << " \"" << val << "\" is not a number! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Value of " << Symbols::Name(varId1) << "." << attributeId1 << " \"" << val << "\" is not a number! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
     int nval = 0;
@@ -745,19 +865,19 @@ int CompareAttribute::GetValueL(string val) const
     catch (invalid_argument&)
     {
         stringstream ss;
-        ss << "Value of " << varId1 << "." << attributeId1 << " \"" << val << "\" is not a number! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Value of " << Symbols::Name(varId1) << "." << attributeId1 << " \"" << val << "\" is not a number! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
     return nval;
 }
 
-int CompareAttribute::GetValueR(string val) const
+Expected<int> CompareAttribute::GetValueR(string val) const
 {   
     if (!isNumber(val))
     {
         stringstream ss;
-        ss << "Value of " << varId2 << "." << attributeId2 << " \"" << val << "\" is not a number! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Value of " << Symbols::Name(varId2) << "." << attributeId2 << " \"" << val << "\" is not a number! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
     int nval = 0;
@@ -768,63 +888,74 @@ int CompareAttribute::GetValueR(string val) const
     catch (invalid_argument&)
     {
         stringstream ss;
-        ss << "Value of " << varId2 << "." << attributeId2 << " \"" << val << "\" is not a number! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Value of " << Symbols::Name(varId2) << "." << attributeId2 << " \"" << val << "\" is not a number! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
     return nval;
 }
 
-void CompareAttribute::Exec(Interpreter & interpreter)
+RuntimeError CompareAttribute::Exec(Interpreter & interpreter)
 {
     __TRACE_EXEC__;
 
+    Expected<VarValue> result = Evaluate(interpreter.stack, interpreter.adapter);
+    if (result.Failed()) return move(result.Error());
+
+    interpreter.stack.PushReturn(move(result.Value()));
+    return RuntimeError();
+}
 
-    if (!interpreter.stack.Exists(varId1))
+Expected<VarValue> CompareAttribute::Evaluate(const VariableSet& variables, IAdapter* adapter, unsigned int base) const
+{
+    unsigned int at1 = base + slot1;   // slots in the frame
+    unsigned int at2 = base + slot2;
+
+    if (!proven1 && !variables.Exists(at1))
     {
         stringstream ss;
-        ss << "Unknown variable " << varId1 << " @Line:" << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Unknown variable " << Symbols::Name(varId1) << " @Line:" << t.line;
+        return RuntimeError(ss.str());
     }
-    if (!interpreter.stack.Exists(varId2))
+    if (!proven2 && !variables.Exists(at2))
     {
         stringstream ss;
-        ss << "Unknown variable " << varId2 << " @Line:" << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Unknown variable " << Symbols::Name(varId2) << " @Line:" << t.line;
+        return RuntimeError(ss.str());
     }
 
-    VarValue val1 = interpreter.stack.GetValue(varId1);
-    VarValue val2 = interpreter.stack.GetValue(varId2);
+    const VarValue& val1 = variables.GetValue(at1);
+    const VarValue& val2 = variables.GetValue(at2);
 
     if (val1.size() != 1)
     {
         stringstream ss;
-        ss << "Variable \"" << varId1 << "\" has no value! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable \"" << Symbols::Name(varId1) << "\" has no value! @Line: " << t.line;
+        return RuntimeError(ss.str());
 
     }
     if (val2.size() != 1)
     {
         stringstream ss;
-        ss << "Variable \"" << varId2 << "\" has no value! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable \"" << Symbols::Name(varId2) << "\" has no value! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
 
 
-    ATTR_PTR attributes1 = interpreter.adapter->GetAttributesOf(val1[0]);
-    ATTR_PTR attributes2 = interpreter.adapter->GetAttributesOf(val2[0]);
+    ATTR_PTR attributes1 = adapter->GetAttributesOf(val1[0]);
+    ATTR_PTR attributes2 = adapter->GetAttributesOf(val2[0]);
 
     if (!attributes1)
     {
         stringstream ss;
-        ss << "Variable named \"" << varId1 << "\" has no attributes! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId1) << "\" has no attributes! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
     if (!attributes2)
     {
         stringstream ss;
-        ss << "Variable named \"" << varId2 << "\" has no attributes! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId2) << "\" has no attributes! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
 
@@ -832,23 +963,39 @@ void CompareAttribute::Exec(Interpreter & interpreter)
     if (!attributes1->Exists(attributeId1))
     {
         stringstream ss;
-        ss << "Variable named \"" << varId1 << "\" has no attribute named \"" << attributeId1 << "\" ! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId1) << "\" has no attribute named \"" << attributeId1 << "\" ! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
     if (!attributes2->Exists(attributeId2))
     {
         stringstream ss;
-        ss << "Variable named \"" << varId2 << "\" has no attribute named \"" << attributeId2 << "\" ! @Line: " << t.line;
-        throw RuntimeException(ss.str().c_str());
+        ss << "Variable named \"" << Symbols::Name(varId2) << "\" has no attribute named \"" << attributeId2 << "\" ! @Line: " << t.line;
+        return RuntimeError(ss.str());
     }
 
-    string valAttr1 = prefix1 + attributes1->GetValueOf(attributeId1) + postfix1;
-    string valAttr2 = prefix2 + attributes2->GetValueOf(attributeId2) + postfix2;
+    string valAttr1(prefix1);
+    valAttr1 += attributes1->GetValueOf(attributeId1);
+    valAttr1 += postfix1;
+    string valAttr2(prefix2);
+    valAttr2 += attributes2->GetValueOf(attributeId2);
+    valAttr2 += postfix2;
     _TRACE_("        prefix1 = \"" << prefix1 << "\", postfix1 = \"" << postfix1 << "\"" << endl);
     _TRACE_("        prefix2 = \"" << prefix2 << "\", postfix2 = \"" << postfix2 << "\"" << endl);
     _TRACE_("        valAttr1 = \"" << valAttr1 << "\", valAttr2 = \"" << valAttr2 << "\"" << endl );
     
     VarValue result;
+
+    int number1 = 0, number2 = 0;   // of the attributes, for the comparisons
+    if (checkType == CheckType::LT || checkType == CheckType::GT || checkType == CheckType::LE || checkType == CheckType::GE)
+    {
+        Expected<int> value1 = GetValueL(valAttr1);
+        if (value1.Failed()) return move(value1.Error());
+        Expected<int> value2 = GetValueR(valAttr2);
+        if (value2.Failed()) return move(value2.Error());
+
+        number1 = value1.Value();
+        number2 = value2.Value();
+    }
    
     switch (checkType)
     {
@@ -856,37 +1003,37 @@ void CompareAttribute::Exec(Interpreter & interpreter)
 
         if (valAttr1 == valAttr2)
         {
-            result.push_back(0); // dummy element to signal TRUE ... empty vector means FALSE
+            result = VarValue::True(); // dummy element to signal TRUE ... empty vector means FALSE
         }
 
         break;
     case CheckType::LT:
-        if (GetValueL(valAttr1) < GetValueR(valAttr2))
+        if (number1 < number2)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::GT:
-        if (GetValueL(valAttr1) > GetValueR(valAttr2))
+        if (number1 > number2)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::LE:
-        if (GetValueL(valAttr1) <= GetValueR(valAttr2))
+        if (number1 <= number2)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     case CheckType::GE:
-        if (GetValueL(valAttr1) >= GetValueR(valAttr2))
+        if (number1 >= number2)
         {
-            result.push_back(0);
+            result = VarValue::True();
         }
         break;
     default:
         break;
     }
 
-    interpreter.stack.PushReturn(result);
+    return result;
 }
\ No newline at end of file
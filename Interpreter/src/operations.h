@@ -2,23 +2,77 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <atomic>
+#include <mutex>
 #include "types.h"
 #include "operation.h"
 #include "token.h"
+#include "source_file.h"
+#include "symbols.h"
+#include "bytecode.h"
+#include "frames.h"
+#include "arena.h"
+
+class IAdapter;
 
 
 
 class Function : public Operation
 {
 private:
-    std::string id;
-    std::vector<OP_PTR> operations;
-    std::vector<std::string> parameters;
+    SymbolId id;
+    std::vector<SymbolId> parameters;
+    SOURCE_PTR source;      // keeps the rule file alive, the text of the function points into it
+
+    // the body of a lazily loaded function is parsed on first use, by the first thread that needs it
+    SourceRange body;
+    TokenInfo location;     // of the function name, the body is in the arena
+    mutable std::unique_ptr<OperationArena> arena;     // of the body, made when the body is parsed
+    mutable OpList operations;
+    mutable std::atomic<bool> parsed;
+    mutable std::mutex parseMutex;
+    mutable std::string parseError;
+
+    mutable Bytecode bytecode;              // compiled on the first call by the bytecode engine
+    mutable std::atomic<bool> compiled;
+
+    mutable Closure closure;                // bound on the first call by the closure engine
+    mutable std::atomic<bool> bound;
+
+    mutable FrameLayout frame;              // slots of the variables, laid out when the body is parsed
+
+    bool isVolatile;                        // VOLATILE, runs on every call even if it is pure (memo.h)
+
+private:
+    void LayOut() const;
 public:
-    Function(std::string functionId, std::vector<OP_PTR> ops, std::vector<std::string> parameters, Token idTok);
-    std::string getId() const { return id; }
-    std::vector<std::string> getParams() const { return parameters; }
-    void Exec(Interpreter & interpreter);
+    // ops are in the arena, the function keeps the arena
+    Function(SymbolId functionId, OpList ops, std::vector<SymbolId> parameters, const TokenInfo& idTok, SOURCE_PTR source, std::unique_ptr<OperationArena> arena);
+    Function(SymbolId functionId, std::vector<SymbolId> parameters, SourceRange body, const TokenInfo& idTok, SOURCE_PTR source);   // lazy
+    std::string_view getId() const { return Symbols::Name(id); }
+    SymbolId getSymbol() const { return id; }
+    const std::vector<SymbolId>& getParams() const { return parameters; }
+    const SOURCE_PTR& Source() const { return source; }
+    bool IsParsed() const { return parsed.load(std::memory_order_acquire); }
+    bool IsVolatile() const { return isVolatile; }
+    void SetVolatile() { isVolatile = true; }     // by the parser, before the function is shared
+    std::string Validate() const;   // parses the body if it was not parsed yet, returns the parse error or empty
+    RuntimeError Parse() const;     // parses the body if it was not parsed yet, returns the parse error as a runtime error
+    const FrameLayout& Frame() const;   // the body must have parsed (Parse)
+    const Bytecode& Compiled() const;   // compiles the body if it was not compiled yet, the body must have parsed
+    const Closure& Bound() const;       // binds the body if it was not bound yet, the body must have parsed
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    void Inline(BytecodeWriter & out, const TokenInfo & call) const;    // the body at a call site of a caller (function_table.h)
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
+
+    // moves the function 'delta' lines down in its file, not while another thread uses it. The code of
+    // the bytecode and closure engines keeps its lines, the incremental parser's functions never run.
+    void ShiftLines(int delta);
 };
 
 typedef std::shared_ptr<Function> FUNC_PTR;
@@ -28,11 +82,16 @@ typedef std::shared_ptr<Function> FUNC_PTR;
 class FunctionCall : public Operation
 {
 private:
-    std::string id;
-    std::vector<OP_PTR> parameters;
+    SymbolId id;
+    OpList parameters;
 public:
-    FunctionCall(std::string functionId, std::vector<OP_PTR> parameters, Token idTok);
-    void Exec(Interpreter & interpreter);
+    FunctionCall(SymbolId functionId, OpList parameters, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -40,22 +99,33 @@ public:
 class SetFunctionValue : public Operation
 {
 private:
-    std::string functionId;
+    SymbolId functionId;
+    unsigned int slot;
     OP_PTR op;
 public:
-    SetFunctionValue(std::string ruleId, OP_PTR op, Token idTok);
-    void Exec(Interpreter & interpreter);
+    SetFunctionValue(SymbolId ruleId, OP_PTR op, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 class ConditionalBlock : public Operation
 {
 private:
-    std::vector<OP_PTR> const sBlocks;  // serial blocks => AND
-    std::vector<OP_PTR> const pBlocks;  // paralel blocks => OR
+    const OpList sBlocks;  // serial blocks => AND
+    const OpList pBlocks;  // paralel blocks => OR
 public:
-    ConditionalBlock(std::vector<OP_PTR> sBlocks, std::vector<OP_PTR> pBlocks, Token idTok);
-    ConditionalBlock(Token idTok);      // for atomic elements
-    virtual void Exec(Interpreter & interpreter);
+    ConditionalBlock(OpList sBlocks, OpList pBlocks, const TokenInfo& idTok);
+    ConditionalBlock(const TokenInfo& idTok);      // for atomic elements
+    virtual RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -63,11 +133,16 @@ class IfStmt : public Operation
 {
 private:
     const OP_PTR condition;
-    std::vector<OP_PTR> thanOperations;
-    std::vector<OP_PTR> elseOperations;
+    OpList thanOperations;
+    OpList elseOperations;
 public:
-    IfStmt(OP_PTR cond, std::vector<OP_PTR> thanOps, std::vector<OP_PTR> elseOps, Token idTok);
-    void Exec(Interpreter & interpreter);
+    IfStmt(OP_PTR cond, OpList thanOps, OpList elseOps, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -76,10 +151,15 @@ class WhileLoop : public Operation
 {
 private:
     const OP_PTR condition;
-    std::vector<OP_PTR> operations;
+    OpList operations;
 public:
-    WhileLoop(OP_PTR cond, std::vector<OP_PTR> ops, Token idTok);
-    void Exec(Interpreter & interpreter);
+    WhileLoop(OP_PTR cond, OpList ops, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -88,12 +168,18 @@ public:
 class ForLoop : public Operation
 {
 private:
-    std::string id;
+    SymbolId id;
+    unsigned int slot;
     const OP_PTR dataGetter;
-    std::vector<OP_PTR> operations;
+    OpList operations;
 public:
-    ForLoop(std::string i, OP_PTR d, std::vector<OP_PTR> o, Token idTok);
-    void Exec(Interpreter & interpreter);
+    ForLoop(SymbolId i, OP_PTR d, OpList o, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -101,21 +187,34 @@ public:
 class Variable : public Operation
 {
 private:
-    std::string id;
+    SymbolId id;
+    unsigned int slot;
+    bool proven;        // defined on every path, not checked at run time
 public:
-    Variable(std::string varId, Token idTok);
-    void Exec(Interpreter & interpreter);
+    Variable(SymbolId varId, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
 class VariableAssignment : public Operation
 {
 private:
-    std::string id;
+    SymbolId id;
+    unsigned int slot;
     const OP_PTR valueGetter;
 public:
-    VariableAssignment(std::string varId, OP_PTR valueGetter, Token idTok);
-    void Exec(Interpreter & interpreter);
+    VariableAssignment(SymbolId varId, OP_PTR valueGetter, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -125,8 +224,13 @@ class NOT : public Operation
 private:
     const OP_PTR expression;
 public:
-    NOT(OP_PTR expression, Token idTok);
-    void Exec(Interpreter & interpreter);
+    NOT(OP_PTR expression, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -134,8 +238,13 @@ public:
 class TRUE_VAL : public Operation
 {
 public:
-    TRUE_VAL(Token idTok);
-    void Exec(Interpreter & interpreter);
+    TRUE_VAL(const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -143,8 +252,13 @@ public:
 class FALSE_VAL : public Operation
 {
 public:
-    FALSE_VAL(Token idTok);
-    void Exec(Interpreter & interpreter);
+    FALSE_VAL(const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -152,10 +266,17 @@ public:
 class NullCheck : public Operation
 {
 private:
-    std::string varId;
+    SymbolId varId;
+    unsigned int slot;
+    bool proven;
 public:
-    NullCheck(std::string variableId, Token idTok);
-    void Exec(Interpreter & interpreter);
+    NullCheck(SymbolId variableId, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -164,8 +285,13 @@ class PRINTS : public Operation
 private:
     std::string msg;
 public:
-    PRINTS(std::string message, Token idTok);
-    void Exec(Interpreter & interpreter);
+    PRINTS(std::string message, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -175,8 +301,13 @@ class PRINT : public Operation
 private:
     const OP_PTR operation;
 public:
-    PRINT(OP_PTR op, Token idTok);
-    void Exec(Interpreter & interpreter);
+    PRINT(OP_PTR op, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -186,8 +317,13 @@ class CONDITIONS_OF : public Operation
 private:
     const OP_PTR operation;
 public:
-    CONDITIONS_OF(OP_PTR op, Token idTok);
-    void Exec(Interpreter & interpreter);
+    CONDITIONS_OF(OP_PTR op, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -197,8 +333,13 @@ class PARENT : public Operation
 private:
     const OP_PTR operation;
 public:
-    PARENT(OP_PTR op, Token idTok);
-    void Exec(Interpreter & interpreter);
+    PARENT(OP_PTR op, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -208,8 +349,13 @@ class GET_NODES_OF_TYPE : public Operation
 private:
     std::string typeName;
 public:
-    GET_NODES_OF_TYPE(std::string nodeTypeName, Token idTok);
-    void Exec(Interpreter & interpreter);
+    GET_NODES_OF_TYPE(std::string nodeTypeName, const TokenInfo& idTok);
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -228,15 +374,23 @@ enum CheckType
 class AttributeCheck : public Operation
 {
 private:
-    std::string varId;
-    std::string attributeId;
-    std::string attribVal;
+    SymbolId varId;
+    unsigned int slot;
+    bool proven;
+    std::string attributeId;    // passed to IAttributes, kept as std::string
+    std::string_view attribVal;
     CheckType checkType;
 private:
-    int GetValue(std::string val);
+    Expected<int> GetValue(std::string val) const;
 public:
-    AttributeCheck(std::string variableId, std::string attributeName, std::string attributeValue, CheckType checkType, Token idTok);
-    void Exec(Interpreter & interpreter);
+    AttributeCheck(SymbolId variableId, std::string attributeName, std::string_view attributeValue, CheckType checkType, const TokenInfo& idTok);
+    Expected<VarValue> Evaluate(const VariableSet& variables, IAdapter* adapter, unsigned int base = 0) const;    // base: first slot of the body in the frame (inliner)
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
 
 
@@ -244,24 +398,34 @@ public:
 class CompareAttribute : public Operation
 {
 private:
-    std::string varId1;
+    SymbolId varId1;
+    unsigned int slot1;
+    bool proven1;
     std::string attributeId1;
-    std::string prefix1;
-    std::string postfix1;
+    std::string_view prefix1;
+    std::string_view postfix1;
 
-    std::string varId2;
+    SymbolId varId2;
+    unsigned int slot2;
+    bool proven2;
     std::string attributeId2;
-    std::string prefix2;
-    std::string postfix2;
+    std::string_view prefix2;
+    std::string_view postfix2;
 
     CheckType checkType;
 private:
-    int GetValueL(std::string val) const;
-    int GetValueR(std::string val) const;
+    Expected<int> GetValueL(std::string val) const;
+    Expected<int> GetValueR(std::string val) const;
 public:
     CompareAttribute(
-        std::string variableId1, std::string attributeName1, std::string prefix1, std::string postfix1,
-        std::string variableId2, std::string attributeName2, std::string prefix2, std::string postfix2,
-        CheckType checkType, Token idTok);
-    void Exec(Interpreter & interpreter);
+        SymbolId variableId1, std::string attributeName1, std::string_view prefix1, std::string_view postfix1,
+        SymbolId variableId2, std::string attributeName2, std::string_view prefix2, std::string_view postfix2,
+        CheckType checkType, const TokenInfo& idTok);
+    Expected<VarValue> Evaluate(const VariableSet& variables, IAdapter* adapter, unsigned int base = 0) const;    // base: first slot of the body in the frame (inliner)
+    RuntimeError Exec(Interpreter & interpreter);
+    void Serialize(ImageWriter & out) const;
+    void Compile(BytecodeWriter & out) const;
+    Closure Bind() const;
+    std::string Generate(NativeWriter & out) const;
+    void Resolve(FrameResolver & out);
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "parallel.h"
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+unsigned int Parallel::WorkerCount(unsigned int requested, size_t items)
+{
+    unsigned int workers = requested ? requested : thread::hardware_concurrency();
+
+    if (workers == 0) workers = 1;
+    if (workers > items) workers = (unsigned int)items;
+
+    return workers;
+}
+
+void Parallel::For(size_t count, unsigned int workers, const function<void(size_t, unsigned int)>& task)
+{
+    if (count == 0) return;
+
+    vector<exception_ptr> errors(count);
+
+    if (workers <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            try { task(i, 0); }
+            catch (...) { errors[i] = current_exception(); }
+        }
+    }
+    else
+    {
+        atomic<size_t> next(0);
+
+        auto worker = [&](unsigned int w)
+        {
+            for (size_t i = next++; i < count; i = next++)
+            {
+                try { task(i, w); }
+                catch (...) { errors[i] = current_exception(); }
+            }
+        };
+
+        vector<thread> threads;
+        for (unsigned int w = 1; w < workers; w++)
+        {
+            threads.emplace_back(worker, w);
+        }
+
+        worker(0); // the calling thread works too
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    for (auto& e : errors)
+    {
+        if (e) rethrow_exception(e);
+    }
+}
\ No newline at end of file
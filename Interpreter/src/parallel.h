@@ -0,0 +1,13 @@
+#pragma once
+
+#include <functional>
+
+namespace Parallel {
+    // number of workers to use for 'items' work items, 'requested' == 0 means one per hardware thread
+    unsigned int WorkerCount(unsigned int requested, size_t items);
+
+    // Runs task(index, worker) for every index in [0, count) on 'workers' threads.
+    // Each worker index is used by one thread only, so per worker state needs no locking.
+    // If tasks throw, the exception of the lowest index is rethrown on the calling thread.
+    void For(size_t count, unsigned int workers, const std::function<void(size_t index, unsigned int worker)>& task);
+}
\ No newline at end of file
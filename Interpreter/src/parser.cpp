@@ -4,208 +4,401 @@
 #include <iostream>
 #include <algorithm>
 #include <memory>
-#include <regex>
 #include <iterator>
 #include "operations.h"
 #include "trace.h"
 #include "utils.h"
 #include "parser_exceptions.h"
+#include "tokenizer.h"
+#include "parallel.h"
 
 using namespace std;
 
 #define INDENT "        "
 #define __TRACE_PARSING__ _TRACE_( INDENT << "PARSING > " << __FUNCTION__ << endl);
 
+const unsigned int PARALLEL_PARSE_MIN_SIZE = 256 * 1024;  // smaller files are parsed faster than they are split
+
 LangParser::LangParser()
+    : lazy(false), arena(nullptr)
 {
     __TRACE_PARSING__;
     
    _TRACE_( endl << "LANGUAGE KEYWORDS" << endl << "=================" << endl);
-   _TRACE_( symFOR << endl);
-   _TRACE_( symIN << endl);
-   _TRACE_( symWHILE << endl);
-   _TRACE_( symIF << endl);
-   _TRACE_( symTHEN << endl);
-   _TRACE_( symELSE << endl);
-   _TRACE_( symEND << endl);
-   _TRACE_( symNOT << endl);
-   _TRACE_( symOR << endl);
-   _TRACE_( symAND << endl);
-   _TRACE_( symFALSE << endl);
-   _TRACE_( symTRUE << endl);
-   _TRACE_( symNULL << endl);
-   _TRACE_(symENDL << endl);
+   _TRACE_( Symbols::Name(symFOR) << endl);
+   _TRACE_( Symbols::Name(symIN) << endl);
+   _TRACE_( Symbols::Name(symWHILE) << endl);
+   _TRACE_( Symbols::Name(symIF) << endl);
+   _TRACE_( Symbols::Name(symTHEN) << endl);
+   _TRACE_( Symbols::Name(symELSE) << endl);
+   _TRACE_( Symbols::Name(symEND) << endl);
+   _TRACE_( Symbols::Name(symNOT) << endl);
+   _TRACE_( Symbols::Name(symOR) << endl);
+   _TRACE_( Symbols::Name(symAND) << endl);
+   _TRACE_( Symbols::Name(symFALSE) << endl);
+   _TRACE_( Symbols::Name(symTRUE) << endl);
+   _TRACE_( Symbols::Name(symNULL) << endl);
+   _TRACE_( Symbols::Name(symENDL) << endl);
+   _TRACE_( Symbols::Name(symIMPORT) << endl);
+   _TRACE_( Symbols::Name(symVOLATILE) << endl);
    
    _TRACE_( endl << "VARIABLE PREFIX" << endl << "====================" << endl);
 
    _TRACE_( endl << "BOOL VARIABLE PREFIX" << endl << "====================" << endl);
-   _TRACE_( symHASH << endl);
+   _TRACE_( Symbols::Name(symHASH) << endl);
 
    _TRACE_( endl << "USER DEFINED / NONSPECIFIC KEYWORDS" << endl << "===================================" << endl);
-   _TRACE_( symGET_NODES_OF_TYPE << endl);
-   _TRACE_( symCONDITIONS_OF << endl);
-   _TRACE_( symPARENT << endl);
-   _TRACE_( symPRINT << endl);
-   _TRACE_( symPRINTS << endl);
-   _TRACE_( symSTARTS_WITH << endl);
-   _TRACE_( symENDS_WITH << endl);
-   _TRACE_( symCONTAINS << endl);
+   _TRACE_( Symbols::Name(symGET_NODES_OF_TYPE) << endl);
+   _TRACE_( Symbols::Name(symCONDITIONS_OF) << endl);
+   _TRACE_( Symbols::Name(symPARENT) << endl);
+   _TRACE_( Symbols::Name(symPRINT) << endl);
+   _TRACE_( Symbols::Name(symPRINTS) << endl);
+   _TRACE_( Symbols::Name(symSTARTS_WITH) << endl);
+   _TRACE_( Symbols::Name(symENDS_WITH) << endl);
+   _TRACE_( Symbols::Name(symCONTAINS) << endl);
    
    _TRACE_( endl << "DELIMITERS" << endl << "==========" << endl);
-   delimiters.push_back(symHASH);
-   delimiters.push_back(symAT);
-   delimiters.push_back(symCOLON);
-   delimiters.push_back(symSEMICOLON);
-   delimiters.push_back(symEQUAL);
-   delimiters.push_back(symLOWER);
-   delimiters.push_back(symGREATER);
-   delimiters.push_back(symPLUS);
-   delimiters.push_back(symDOT);
-   delimiters.push_back(symCOMMA);
-   delimiters.push_back(symQUOTE);
-   delimiters.push_back(symROUNDOPEN);
-   delimiters.push_back(symROUNDCLOSE);
-   delimiters.push_back(symSPACE);
-   for (auto delimiter:delimiters)
-   {
-       _TRACE_( delimiter << endl);
-   }
+   _TRACE_( Symbols::Name(symHASH) << endl);
+   _TRACE_( Symbols::Name(symAT) << endl);
+   _TRACE_( Symbols::Name(symCOLON) << endl);
+   _TRACE_( Symbols::Name(symSEMICOLON) << endl);
+   _TRACE_( Symbols::Name(symEQUAL) << endl);
+   _TRACE_( Symbols::Name(symLOWER) << endl);
+   _TRACE_( Symbols::Name(symGREATER) << endl);
+   _TRACE_( Symbols::Name(symPLUS) << endl);
+   _TRACE_( Symbols::Name(symDOT) << endl);
+   _TRACE_( Symbols::Name(symCOMMA) << endl);
+   _TRACE_( Symbols::Name(symQUOTE) << endl);
+   _TRACE_( Symbols::Name(symROUNDOPEN) << endl);
+   _TRACE_( Symbols::Name(symROUNDCLOSE) << endl);
    
    _TRACE_( endl << endl);
 }
 
-#define CALLFN(object,ptr)  ((object).*(ptr))
-
-OP_PTR LangParser::Try(OpParserFunc func)
+ParseResult LangParser::parse(string path, bool lazyBodies, unsigned int threads)
 {
-    OP_PTR result;
+    __TRACE_PARSING__;
 
-    tm.SaveCurrent();
+    SOURCE_PTR source;
 
     try
     {
-        result = CALLFN(*this, func)(); // execute the parser function
+        source = SourceFile::Open(path);
     }
-    catch (const ParseException&)
+    catch (const invalid_argument& e)
     {
-        tm.RestoreCurrent(); // do nothing, we only tried to parse
+        ParseResult result;
+        result.path = path;
+        result.hash = 0;
+
+        stringstream ss;
+        ss << "PARSER ERROR: " << e.what();
+        result.error = ss.str();
+
+        _TRACE_("        " << result.error << endl);
+        return result;
     }
 
-    return result;
+    return parse(source, lazyBodies, threads);
 }
 
+ParseResult LangParser::parse(SOURCE_PTR source, bool lazyBodies, unsigned int threads)
+{
+    // a lazy parse is about as fast as the split
+    if (threads > 1 && !lazyBodies && source->Text().size() >= PARALLEL_PARSE_MIN_SIZE)
+    {
+        return parseParts(source, lazyBodies, threads);
+    }
+
+    return parse(source, { 0, (unsigned int)source->Text().size(), 1 }, lazyBodies);
+}
 
-vector<FUNC_PTR> LangParser::parse(string path)
+ParseResult LangParser::parseParts(SOURCE_PTR source, bool lazyBodies, unsigned int threads)
 {
     __TRACE_PARSING__;
 
-    vector<FUNC_PTR> functions;
-    
-    cout << path;
+    const SourceRange whole = { 0, (unsigned int)source->Text().size(), 1 };
 
-    try
+    SplitResult definitions = split(source, whole);
+
+    if (!definitions.error.empty() || definitions.definitions.size() < 2)
+    {
+        return parse(source, whole, lazyBodies); // reports the error where the serial parse does
+    }
+
+    // parts of about the same size, a few per thread so a slow part does not hold up the others.
+    // The tokens of a part start at its first '@', so they have the same lines as in the whole file.
+    vector<SourceRange> parts;
+    const unsigned int partSize = whole.end / (threads * 4) + 1;
+
+    for (auto& def : definitions.definitions)
     {
-        tm.SetTokens( Tokenizer::getTokensFromFile(path, delimiters) );
+        if (parts.empty() || parts.back().end - parts.back().begin >= partSize) parts.push_back(def);
+        else                                                                    parts.back().end = def.end;
+    }
 
-        OP_PTR op = Parse_FunctionDefinition();
-        while (op)
+    _TRACE_("        PARSING " << definitions.definitions.size() << " FUNCTIONS IN " << parts.size() << " PARTS" << endl);
+
+    unsigned int workers = Parallel::WorkerCount(threads, parts.size());
+    vector<LangParser> parsers(workers);
+    vector<ParseResult> results(parts.size());
+
+    Parallel::For(parts.size(), workers, [&](size_t i, unsigned int worker)
+    {
+        results[i] = parsers[worker].parse(source, parts[i], lazyBodies);
+    });
+
+    ParseResult result;
+    result.path = source->Path();
+    result.hash = source->Hash();
+    result.imports = definitions.imports;   // outside of the parts
+
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        if (!results[i].error.empty())
         {
-            functions.push_back(dynamic_pointer_cast<Function>(op));
+            // parsed on serially from this part, so the error and the functions before it are the ones of a serial parse
+            ParseResult rest = parse(source, { parts[i].begin, whole.end, parts[i].line }, lazyBodies);
 
-            if (tm.NoMoreTokens()) { op = 0; }
-            else                   { op = Parse_FunctionDefinition(); }
+            result.functions.insert(result.functions.end(), rest.functions.begin(), rest.functions.end());
+            result.error = rest.error;
+            break;
         }
 
-        cout << "OK";
+        result.functions.insert(result.functions.end(), results[i].functions.begin(), results[i].functions.end());
+    }
+
+    return result;
+}
+
+ParseResult LangParser::parse(SOURCE_PTR source, SourceRange range, bool lazyBodies)
+{
+    __TRACE_PARSING__;
+
+    const string& path = source->Path();
+    lazy = lazyBodies;
+
+    ParseResult result;
+    result.path = path;
+    result.hash = SourceFile::Hash(source->Text().substr(range.begin, range.end - range.begin));
+
+    try
+    {
+        tm.SetSource(source, range);
+
+        do
+        {
+            if (IS_SYM(symIMPORT)) { result.imports.push_back(Parse_Import()); }
+            else                   { result.functions.push_back(Parse_FunctionDefinition()); }
+        }
+        while (!tm.NoMoreTokens());
     }
     catch (const invalid_argument& e)
     {
-        RED(endl << "PARSER ERROR: " << e.what() << endl);        
-        _TRACE_("        PARSER ERROR: " << e.what() << endl);
+        stringstream ss;
+        ss << "PARSER ERROR: " << e.what();
+        result.error = ss.str();
     }
     catch (const ParseException& e)
     {
-        RED(endl << "PARSER ERROR (file: " << path << ") " << e.what() << endl);
-        _TRACE_("        PARSER ERROR (file: " << path << ") " << e.what() << endl);
+        stringstream ss;
+        ss << "PARSER ERROR (file: " << path << ") " << e.what();
+        result.error = ss.str();
     }
     catch (const BadSyntaxException& e)
     {
-        RED(endl << "PARSER ERROR (file: " << path << ") " << e.what() << endl);
-        _TRACE_("        PARSER ERROR (file: " << path << ") " << e.what() << endl);
+        stringstream ss;
+        ss << "PARSER ERROR (file: " << path << ") " << e.what();
+        result.error = ss.str();
     }
 
-    return functions;
-}
+    if (!result.error.empty() && lazyBodies)
+    {
+        // a scan error may be reported far from its cause (e.g. a missing END),
+        // the full parse reports it where the grammar is violated
+        _TRACE_("        LAZY SCAN FAILED, PARSING FULLY: " << result.error << endl);
+        return parse(source, range, false);
+    }
+
+    if (!result.error.empty())
+    {
+        _TRACE_("        " << result.error << endl);
+    }
 
+    return result;
+}
 
-bool LangParser::IS_SYM(string sym, bool skipSpaces)
+SplitResult LangParser::split(SOURCE_PTR source, SourceRange range)
 {
-    Token t = tm.Current(skipSpaces);
+    __TRACE_PARSING__;
+
+    SplitResult result;
+    bool lexed = false;
+
+    try
+    {
+        tm.SetSource(source, range);
+        lexed = true;
+
+        while (!tm.NoMoreTokens())
+        {
+            if (IS_SYM(symIMPORT))
+            {
+                result.imports.push_back(Parse_Import());
+                continue;
+            }
+
+            const Token& at = tm.Current();     // or the VOLATILE before it
+            unsigned int begin = at.offset;
+            int line = at.line;
+
+            if (IS_SYM(symVOLATILE)) SYM(symVOLATILE);
+            SYM(symAT);
+            TXT();
+            Parse_FnDefinitionParameters();
+            Token colon = tm.Current();
+            SYM(symCOLON);
+
+            result.definitions.push_back({ begin, SKIP_BODY(colon).end, line });
+        }
+    }
+    catch (const ParseException& e)
+    {
+        stringstream ss;
+        ss << "PARSER ERROR (file: " << source->Path() << ") " << e.what();
+        result.error = ss.str();
+    }
+    catch (const BadSyntaxException& e)
+    {
+        stringstream ss;
+        ss << "PARSER ERROR (file: " << source->Path() << ") " << e.what();
+        result.error = ss.str();
+    }
 
-    _TRACE_( INDENT << "IS_SYM checking: " << sym << " found: " << t.tok << " @Line: " << t.line << endl);
+    if (!result.error.empty())
+    {
+        result.truncated = lexed && tm.NoMoreTokens();
+        _TRACE_("        " << result.error << endl);
+    }
 
-    return t.tok.compare(sym) == 0;
+    return result;
 }
 
+OpList LangParser::parseBody(SOURCE_PTR source, SourceRange body, OperationArena& bodyArena, string& error)
+{
+    __TRACE_PARSING__;
 
-void LangParser::SYM(string sym)
-{   
-    Token t = tm.GetNext();
+    OpList operations;
+    lazy = false;
+    arena = &bodyArena;
 
-    if (t.tok.compare(sym) != 0)
+    try
+    {
+        tm.SetSource(source, body);
+
+        operations = List(Parse_EmbeddedOperations());
+
+        if (!tm.NoMoreTokens())
+        {
+            stringstream ss;
+            ss << "@line: " << tm.Current().line << " - Expected end of function, found: " << tm.Text(tm.Current());
+            throw BadSyntaxException(ss.str().c_str());
+        }
+    }
+    catch (const ParseException& e)
     {
         stringstream ss;
-        ss << "@line: " << t.line << " - Expected: " << sym << " found: " << t.tok;
-        throw ParseException(ss.str().c_str());
+        ss << "PARSER ERROR (file: " << source->Path() << ") " << e.what();
+        error = ss.str();
+    }
+    catch (const BadSyntaxException& e)
+    {
+        stringstream ss;
+        ss << "PARSER ERROR (file: " << source->Path() << ") " << e.what();
+        error = ss.str();
     }
 
-    _TRACE_("" << sym << " >> line " << t.line << " GET_SYM" << endl);
+    if (!error.empty())
+    {
+        operations = OpList();     // the operations parsed so far stay in the arena until the function is freed
+        _TRACE_("        " << error << endl);
+    }
+
+    return operations;
+}
+
+
+bool LangParser::IS_SYM(Symbol sym)
+{
+    const Token& t = tm.Current();
+
+    _TRACE_( INDENT << "IS_SYM checking: " << Symbols::Name(sym) << " found: " << tm.Text(t) << " @Line: " << t.line << endl);
+
+    return t.sym == sym;
 }
 
 
-int LangParser::NUM()
+bool LangParser::IS_SYM_AT(unsigned int ahead, Symbol sym)
 {
-    Token t = tm.GetNext();
+    return tm.Peek(ahead).sym == sym;
+}
 
-    if (!isNumber(t.tok))
+
+bool LangParser::IS_QUOTED_TEXT()
+{
+    return tm.Current().kind == TokenKind::STRING;
+}
+
+
+void LangParser::SYM(Symbol sym)
+{   
+    const Token& t = tm.GetNext();
+
+    if (t.sym != sym)
     {
         stringstream ss;
-        ss << "@line: " << t.line << " -  Number expected, found: " << t.tok;
+        ss << "@line: " << t.line << " - Expected: " << Symbols::Name(sym) << " found: " << tm.Text(t);
         throw ParseException(ss.str().c_str());
     }
 
-    int n = stoi(t.tok);
-    _TRACE_( n << " >> line " << t.line << " GET_NUM" << endl);
-    return n;
+    _TRACE_("" << Symbols::Name(sym) << " >> line " << t.line << " GET_SYM" << endl);
 }
 
-string LangParser::ANY()
+
+string_view LangParser::NUM()
 {
-    Token t = tm.GetNext(false);
+    const Token& t = tm.GetNext();
 
-    _TRACE_( t.tok << " >> line " << t.line << " GET_ANY" << endl);
+    if (t.kind != TokenKind::NUMBER)
+    {
+        stringstream ss;
+        ss << "@line: " << t.line << " -  Number expected, found: " << tm.Text(t);
+        throw ParseException(ss.str().c_str());
+    }
 
-    return t.tok;
+    int n = stoi(string(tm.Text(t))); // throws if the number is out of range
+    _TRACE_( n << " >> line " << t.line << " GET_NUM" << endl);
+    return tm.Text(t);
 }
 
-string LangParser::TXT()
+SymbolId LangParser::TXT()
 {
-    Token t = tm.GetNext();
+    const Token& t = tm.GetNext();
 
-    if (!isAlphaNumeric(t.tok))
+    if (t.kind != TokenKind::IDENTIFIER && t.kind != TokenKind::NUMBER)
     {
         stringstream ss;
-        ss << "@line: " << t.line << " - Alpha-numeric expected, found: " << t.tok;
+        ss << "@line: " << t.line << " - Alpha-numeric expected, found: " << tm.Text(t);
         throw ParseException(ss.str().c_str());
     }
 
-    _TRACE_( t.tok << " >> line " << t.line << " GET_TXT" << endl);
-    return t.tok;
+    _TRACE_( tm.Text(t) << " >> line " << t.line << " GET_TXT" << endl);
+    return t.sym;
 }
 
-vector<string> LangParser::Parse_FnDefinitionParameters()
+vector<SymbolId> LangParser::Parse_FnDefinitionParameters()
 {
-    vector<string> params;
+    vector<SymbolId> params;
 
     if (IS_SYM(symROUNDOPEN))
     {
@@ -224,18 +417,55 @@ vector<string> LangParser::Parse_FnDefinitionParameters()
     return params;
 }
 
-OP_PTR LangParser::Parse_FunctionDefinition()
+// IMPORT "helpers.rul"
+string LangParser::Parse_Import()
 {
     __TRACE_PARSING__;
 
+    SYM(symIMPORT);
+    string path(QUOTED_TEXT());
+
+    bool absolute = (!path.empty() && (path[0] == '\\' || path[0] == '/')) || (path.size() > 1 && path[1] == ':');
+    if (absolute) return path;
+
+    const string& importer = tm.Source()->Path();
+    size_t slash = importer.find_last_of("\\/");
+
+    return (slash == string::npos) ? path : importer.substr(0, slash + 1) + path;
+}
+
+// [VOLATILE] @Name(params): ... END, a VOLATILE function runs on every call, its results are not memoized
+FUNC_PTR LangParser::Parse_FunctionDefinition()
+{
+    __TRACE_PARSING__;
+
+    bool alwaysRuns = IS_SYM(symVOLATILE);
+    if (alwaysRuns) SYM(symVOLATILE);
+
     SYM(symAT);
-    Token idTok = tm.Current();
-    string ruleId = TXT();
+    TokenInfo idTok = tm.CurrentInfo();
+    SymbolId ruleId = TXT();
     auto params = Parse_FnDefinitionParameters();
+    Token colon = tm.Current();
     SYM(symCOLON);
-    vector<OP_PTR> operations = Parse_EmbeddedOperations();
 
-    return make_shared<Function>(ruleId, operations, params, idTok);
+    FUNC_PTR func;
+
+    if (lazy)
+    {
+        func = make_shared<Function>(ruleId, params, SKIP_BODY(colon), idTok, tm.Source());
+    }
+    else
+    {
+        auto functionArena = make_unique<OperationArena>();
+        arena = functionArena.get();
+        OpList operations = List(Parse_EmbeddedOperations());
+
+        func = make_shared<Function>(ruleId, operations, params, idTok, tm.Source(), move(functionArena));
+    }
+
+    if (alwaysRuns) func->SetVolatile();
+    return func;
 }
 
 
@@ -266,11 +496,11 @@ OP_PTR LangParser::Parse_FunctionCall()
     __TRACE_PARSING__;
 
     SYM(symAT);
-    Token idTok = tm.Current();
-    string functionId = TXT();
+    TokenInfo idTok = tm.CurrentInfo();
+    SymbolId functionId = TXT();
     auto params = Parse_FnCallParameters();
 
-    return make_shared<FunctionCall>(functionId, params, idTok);
+    return New<FunctionCall>(functionId, List(params), Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_FunctionSetReturnValue()
@@ -278,12 +508,12 @@ OP_PTR LangParser::Parse_FunctionSetReturnValue()
     __TRACE_PARSING__;
 
     SYM(symAT);
-    Token idTok = tm.Current();
-    string functionId = TXT();
+    TokenInfo idTok = tm.CurrentInfo();
+    SymbolId functionId = TXT();
     SYM(symEQUAL);
     auto op = Parse_ParalelBlocks();
 
-    return make_shared<SetFunctionValue>(functionId, op, idTok);
+    return New<SetFunctionValue>(functionId, op, Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_Variable()
@@ -291,36 +521,38 @@ OP_PTR LangParser::Parse_Variable()
     __TRACE_PARSING__;
 
     SYM(symHASH);    
-    Token idTok = tm.Current();
-    string id = TXT();
+    TokenInfo idTok = tm.CurrentInfo();
+    SymbolId id = TXT();
 
-    return make_shared<Variable>(id, idTok);
+    return New<Variable>(id, Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_NOT()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symNOT);
     SYM(symROUNDOPEN);
     OP_PTR expression = Parse_ParalelBlocks();
     SYM(symROUNDCLOSE);
     
-    return make_shared<NOT>(expression, idTok);
+    return New<NOT>(expression, Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_BoolValue()
 {
     __TRACE_PARSING__;
 
-    OP_PTR      op = Try(&LangParser::Parse_TRUE);
-    if (!op)    op = Parse_FALSE();
-    if (!op)
+    OP_PTR op = nullptr;
+
+    if (IS_SYM(symTRUE))        op = Parse_TRUE();
+    else if (IS_SYM(symFALSE))  op = Parse_FALSE();
+    else
     {
         stringstream ss;
         ss << "@line: " << tm.Current().line
-            << " - Expected: < TRUE | FALSE > found: " << tm.Current().tok;
+            << " - Expected: < TRUE | FALSE > found: " << tm.Text(tm.Current());
         throw BadSyntaxException(ss.str().c_str());
     }
 
@@ -332,8 +564,8 @@ OP_PTR LangParser::Parse_VariableAssignment()
     __TRACE_PARSING__;
 
     SYM(symHASH);
-    Token idTok = tm.Current();
-    string variableName = TXT();
+    TokenInfo idTok = tm.CurrentInfo();
+    SymbolId variableName = TXT();
     SYM(symEQUAL);
     OP_PTR op = Parse_SerialBlock();
     if (!op)
@@ -341,10 +573,10 @@ OP_PTR LangParser::Parse_VariableAssignment()
         stringstream ss;
         ss << "@line: " << tm.Current().line
             << " - Expected: < ValueExpression > found: "
-            << tm.Current().tok;
+            << tm.Text(tm.Current());
         throw BadSyntaxException(ss.str().c_str());
     }
-    return make_shared<VariableAssignment>(variableName, op, idTok);
+    return New<VariableAssignment>(variableName, op, Locate(idTok));
 }
 
 
@@ -352,33 +584,33 @@ OP_PTR LangParser::Parse_TRUE()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symTRUE);
 
-    return make_shared<TRUE_VAL>(idTok);
+    return New<TRUE_VAL>(Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_FALSE()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symFALSE);
 
-    return make_shared<FALSE_VAL>(idTok);
+    return New<FALSE_VAL>(Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_Parent() // its a try => valid is not out param!
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symPARENT);
     SYM(symROUNDOPEN);
     OP_PTR op = Parse_SerialBlock();
     SYM(symROUNDCLOSE);
 
-    return make_shared<PARENT>(op, idTok);
+    return New<PARENT>(op, Locate(idTok));
 }
 
 
@@ -386,13 +618,13 @@ OP_PTR LangParser::Parse_GET_NODES_OF_TYPE()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symGET_NODES_OF_TYPE);
     SYM(symROUNDOPEN);
-    string nodeKindEnumName = TXT();
+    string nodeKindEnumName(Symbols::Name(TXT()));
     SYM(symROUNDCLOSE);
 
-    return make_shared<GET_NODES_OF_TYPE>(nodeKindEnumName, idTok);
+    return New<GET_NODES_OF_TYPE>(nodeKindEnumName, Locate(idTok));
 }
 
 
@@ -400,13 +632,13 @@ OP_PTR LangParser::Parse_CONDITIONS_OF()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symCONDITIONS_OF);
     SYM(symROUNDOPEN);
     auto nodeExpr = Parse_SerialBlock();
     SYM(symROUNDCLOSE);
 
-    return make_shared<CONDITIONS_OF>(nodeExpr, idTok);
+    return New<CONDITIONS_OF>(nodeExpr, Locate(idTok));
 }
 
 
@@ -414,17 +646,15 @@ OP_PTR LangParser::Parse_ForLoop()
 {
     __TRACE_PARSING__;
 
-    OP_PTR op;
-
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symFOR);
     SYM(symHASH);
-    string loopVariableName = TXT();
+    SymbolId loopVariableName = TXT();
     SYM(symIN);
     auto data_getter = Parse_ValueExpression();
     auto operations  = Parse_EmbeddedOperations();
 
-    return make_shared<ForLoop>(loopVariableName, data_getter, operations, idTok);
+    return New<ForLoop>(loopVariableName, data_getter, List(operations), Locate(idTok));
 }
 
 
@@ -432,7 +662,7 @@ OP_PTR LangParser::Parse_ValueExpression()
 {
     __TRACE_PARSING__;
 
-    OP_PTR op;
+    OP_PTR op = nullptr;
 
     if (IS_SYM(symROUNDOPEN))
     {
@@ -442,23 +672,27 @@ OP_PTR LangParser::Parse_ValueExpression()
     }
     else
     {
-        if (!op)    op = Try(&LangParser::Parse_CompareAttribute);
-        if (!op)    op = Try(&LangParser::Parse_AttributeCheck);
-        if (!op)    op = Try(&LangParser::Parse_NullCheck);
-        if (!op)    op = Try(&LangParser::Parse_Variable);
-        if (!op)    op = Try(&LangParser::Parse_Parent); 
-        if (!op)    op = Try(&LangParser::Parse_NOT);
-        if (!op)    op = Try(&LangParser::Parse_TRUE);
-        if (!op)    op = Try(&LangParser::Parse_FALSE);
-        if (!op)    op = Try(&LangParser::Parse_FunctionCall);
-        if (!op)    op = Try(&LangParser::Parse_CONDITIONS_OF);
-        if (!op)    op = Try(&LangParser::Parse_GET_NODES_OF_TYPE);
+        switch (tm.Current().sym)
+        {
+        case symHASH:               op = Parse_HashExpression(); break;
+        case symPARENT:             op = Parse_Parent(); break;
+        case symNOT:                op = Parse_NOT(); break;
+        case symTRUE:               op = Parse_TRUE(); break;
+        case symFALSE:              op = Parse_FALSE(); break;
+        case symAT:                 op = Parse_FunctionCall(); break;
+        case symCONDITIONS_OF:      op = Parse_CONDITIONS_OF(); break;
+        case symGET_NODES_OF_TYPE:  op = Parse_GET_NODES_OF_TYPE(); break;
+        default:
+            if (IS_QUOTED_TEXT())   op = Parse_CompareAttribute(); // "prefix" + #var.attribute ...
+            break;
+        }
+
         if (!op)
         {
             stringstream ss;
             ss << "@line: " << tm.Current().line
                 << " - Expected: < Variable | AttributeCheck | CompareAttribute | NullCheck | NOT | TRUE | FALSE | FunctionCall | CONDITIONS_OF | GET_NODES_OF_TYPE > found: "
-                << tm.Current().tok;
+                << tm.Text(tm.Current());
             throw BadSyntaxException(ss.str().c_str());
         }
     }
@@ -467,11 +701,60 @@ OP_PTR LangParser::Parse_ValueExpression()
 }
 
 
+OP_PTR LangParser::Parse_HashExpression()
+{
+    __TRACE_PARSING__;
+
+    if (IS_SYM_AT(2, symDOT)) // #var.attribute ...
+    {
+        // the token after #var.attribute tells an AttributeCheck from a CompareAttribute:
+        //   #v.a == "text"           AttributeCheck      #v.a == "text" + #w.b  CompareAttribute
+        //   #v.a < NUMBER, <= ...    AttributeCheck      #v.a < #w.b, <= ...     CompareAttribute
+        //   #v.a.StartsWith(...)     AttributeCheck      #v.a + "text" ...       CompareAttribute
+        unsigned int op = 4;
+        unsigned int operand = 0;
+
+        switch (tm.Peek(op).sym)
+        {
+        case symDOT:
+            return Parse_AttributeCheck();
+        case symPLUS:
+            return Parse_CompareAttribute();
+        case symEQUAL:
+            operand = op + 2;
+            break;
+        case symLOWER:
+        case symGREATER:
+            operand = IS_SYM_AT(op + 1, symEQUAL) ? op + 2 : op + 1;
+            break;
+        default:
+            break;
+        }
+
+        if (operand)
+        {
+            const Token& t = tm.Peek(operand);
+
+            if (t.kind == TokenKind::STRING && !IS_SYM_AT(operand + 1, symPLUS)) return Parse_AttributeCheck();
+            if (t.kind == TokenKind::NUMBER)                                       return Parse_AttributeCheck();
+
+            return Parse_CompareAttribute();
+        }
+    }
+    else if (IS_SYM_AT(2, symEQUAL) && IS_SYM_AT(3, symEQUAL) && IS_SYM_AT(4, symNULL))
+    {
+        return Parse_NullCheck();
+    }
+
+    return Parse_Variable();
+}
+
+
 OP_PTR LangParser::Parse_SerialBlock() // parses operations glued by AND keyword
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
 
     vector<OP_PTR> sBlocks;
     
@@ -482,7 +765,9 @@ OP_PTR LangParser::Parse_SerialBlock() // parses operations glued by AND keyword
         sBlocks.push_back(Parse_ValueExpression());
     }
 
-    return make_shared<ConditionalBlock>(sBlocks, vector<OP_PTR>(), idTok);
+    if (sBlocks.size() == 1) return sBlocks[0];     // a block of one element has the value of the element
+
+    return New<ConditionalBlock>(List(sBlocks), OpList(), Locate(idTok));
 }
 
 
@@ -490,7 +775,7 @@ OP_PTR LangParser::Parse_ParalelBlocks()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
 
     vector<OP_PTR> pBlocks;
     
@@ -501,7 +786,9 @@ OP_PTR LangParser::Parse_ParalelBlocks()
         pBlocks.push_back(Parse_SerialBlock());
     }
 
-    return make_shared<ConditionalBlock>(vector<OP_PTR>(), pBlocks, idTok);
+    if (pBlocks.size() == 1) return pBlocks[0];
+
+    return New<ConditionalBlock>(OpList(), List(pBlocks), Locate(idTok));
 }
 
 
@@ -509,13 +796,13 @@ OP_PTR LangParser::Parse_IfStmt()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symIF);
     OP_PTR condition = Parse_ParalelBlocks();
     auto thanOperations = Parse_ThanOperations();
     auto elseOperations = Parse_ElseOperations();
 
-    return make_shared<IfStmt>(condition, thanOperations, elseOperations, idTok);
+    return New<IfStmt>(condition, List(thanOperations), List(elseOperations), Locate(idTok));
 }
 
 
@@ -523,12 +810,12 @@ OP_PTR LangParser::Parse_WhileLoop()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symWHILE);
     OP_PTR condition = Parse_ParalelBlocks();
     auto operations = Parse_EmbeddedOperations();
 
-    return make_shared<WhileLoop>(condition, operations, idTok);
+    return New<WhileLoop>(condition, List(operations), Locate(idTok));
 }
 
 
@@ -537,38 +824,63 @@ OP_PTR LangParser::Parse_PRINT()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symPRINT);
     SYM(symROUNDOPEN);
     OP_PTR nodeExpr = Parse_SerialBlock();
     SYM(symROUNDCLOSE);
 
-    return make_shared<PRINT>(nodeExpr, idTok);
+    return New<PRINT>(nodeExpr, Locate(idTok));
 }
 
-string LangParser::QUOTED_TEXT()
+// Skips a function body up to the END that closes it. FOR, WHILE and IF open nested blocks.
+// A keyword that follows a delimiter other than ':' or ')' is a name (#END, @IF, GET_NODES_OF_TYPE(FOR)),
+// these never start or end a block.
+SourceRange LangParser::SKIP_BODY(const Token& colon)
 {
-    string text;
+    unsigned int depth = 1;
+    const Token* previous = &colon;
 
-    SYM(symQUOTE);
-    
-    while (!IS_SYM(symQUOTE, false))
+    while (depth)
     {
-        text = text + ANY();
+        const Token& t = tm.GetNext();
+
+        bool statement = previous->kind != TokenKind::DELIMITER || previous->sym == symCOLON || previous->sym == symROUNDCLOSE;
+
+        if (statement && t.kind == TokenKind::IDENTIFIER)
+        {
+            if (t.sym == symFOR || t.sym == symWHILE || t.sym == symIF) depth++;
+            else if (t.sym == symEND)                                   depth--;
+        }
+
+        previous = &t;
     }
 
-    SYM(symQUOTE);
+    _TRACE_("        SKIPPED BODY @line: " << colon.line << " - " << previous->line << endl);
 
-    return text;
+    return { colon.offset + colon.length, previous->offset + previous->length, colon.line };
+}
+
+string_view LangParser::QUOTED_TEXT()
+{
+    const Token& t = tm.GetNext();
+
+    if (t.kind != TokenKind::STRING)
+    {
+        stringstream ss;
+        ss << "@line: " << t.line << " - Expected: " << Symbols::Name(symQUOTE) << " found: " << tm.Text(t);
+        throw ParseException(ss.str().c_str());
+    }
+
+    _TRACE_( tm.Text(t) << " >> line " << t.line << " GET_QUOTED_TEXT" << endl);
+    return tm.Text(t);
 }
 
 OP_PTR LangParser::Parse_PRINTS()
 {
     __TRACE_PARSING__;
 
-    OP_PTR op;
-
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symPRINTS);
     SYM(symROUNDOPEN);
 
@@ -583,12 +895,12 @@ OP_PTR LangParser::Parse_PRINTS()
         SYM(symPLUS);
 
         if (IS_SYM(symENDL)) { SYM(symENDL); text += "\n"; space = ""; }
-        else { text += space + QUOTED_TEXT(); space = " "; }
+        else { text += space; text += QUOTED_TEXT(); space = " "; }
     } 
 
     SYM(symROUNDCLOSE);
 
-    return make_shared<PRINTS>(text, idTok);
+    return New<PRINTS>(text, Locate(idTok));
 }
 
 
@@ -596,21 +908,30 @@ OP_PTR LangParser::Parse_Operation()
 {
     __TRACE_PARSING__;
 
-    OP_PTR      op = Try(&LangParser::Parse_ForLoop);
-    if (!op)	op = Try(&LangParser::Parse_IfStmt);
-    if (!op)	op = Try(&LangParser::Parse_PRINT);
-    if (!op)	op = Try(&LangParser::Parse_PRINTS);
-    if (!op)	op = Try(&LangParser::Parse_FunctionSetReturnValue);
-    if (!op)	op = Try(&LangParser::Parse_FunctionCall);
-    if (!op)	op = Try(&LangParser::Parse_VariableAssignment);
-    if (!op)	op = Try(&LangParser::Parse_WhileLoop);
-    
+    OP_PTR op = nullptr;
+
+    switch (tm.Current().sym)
+    {
+    case symFOR:    op = Parse_ForLoop(); break;
+    case symIF:     op = Parse_IfStmt(); break;
+    case symPRINT:  op = Parse_PRINT(); break;
+    case symPRINTS: op = Parse_PRINTS(); break;
+    case symWHILE:  op = Parse_WhileLoop(); break;
+    case symHASH:   op = Parse_VariableAssignment(); break;
+    case symAT:     // @id = ... sets the return value, anything else is a call
+        if (IS_SYM_AT(2, symEQUAL)) op = Parse_FunctionSetReturnValue();
+        else                        op = Parse_FunctionCall();
+        break;
+    default:
+        break;
+    }
+
     if (!op)
     {
         stringstream ss;
         ss << "@line: " << tm.Current().line
             << " - Expected: < ForLoop | IfStmt | PRINT | PRINTS | FunctionCall | VariableAssignment | WhileLoop > found: "
-            << tm.Current().tok;
+            << tm.Text(tm.Current());
         throw BadSyntaxException(ss.str().c_str());
     }
 
@@ -675,31 +996,27 @@ OP_PTR LangParser::Parse_NullCheck()
 {
     __TRACE_PARSING__;
 
-    OP_PTR op;
-
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symHASH);
-    string variableId = TXT();
+    SymbolId variableId = TXT();
     SYM(symEQUAL);
     SYM(symEQUAL);
     SYM(symNULL);
 
-    return make_shared<NullCheck>(variableId, idTok);
+    return New<NullCheck>(variableId, Locate(idTok));
 }
 
 OP_PTR LangParser::Parse_AttributeCheck()
 {
     __TRACE_PARSING__;
 
-    OP_PTR op;
-
-    Token idTok = tm.Current();
+    TokenInfo idTok = tm.CurrentInfo();
     SYM(symHASH);
-    string variableId = TXT();
+    SymbolId variableId = TXT();
     SYM(symDOT);
-    string attributeName = TXT();
+    string attributeName(Symbols::Name(TXT()));
     
-    string attributeValue;
+    string_view attributeValue;
     CheckType checkType;
 
     if (IS_SYM(symEQUAL))
@@ -725,7 +1042,7 @@ OP_PTR LangParser::Parse_AttributeCheck()
             checkType = CheckType::LT;
         }
 
-        attributeValue = to_string(NUM());
+        attributeValue = NUM();
     }
     else if (IS_SYM(symGREATER))
     {
@@ -741,7 +1058,7 @@ OP_PTR LangParser::Parse_AttributeCheck()
             checkType = CheckType::GT;
         }
 
-        attributeValue = to_string(NUM());
+        attributeValue = NUM();
     }
     else
     {
@@ -766,7 +1083,7 @@ OP_PTR LangParser::Parse_AttributeCheck()
         SYM(symROUNDCLOSE);
     }
 
-    return make_shared<AttributeCheck>(variableId, attributeName, attributeValue, checkType, idTok);
+    return New<AttributeCheck>(variableId, attributeName, attributeValue, checkType, Locate(idTok));
 }
 
 
@@ -774,22 +1091,22 @@ OP_PTR LangParser::Parse_CompareAttribute()
 {
     __TRACE_PARSING__;
 
-    Token idTok = tm.Current();
-    string prefix1, postfix1;
-    string prefix2, postfix2;
+    TokenInfo idTok = tm.CurrentInfo();
+    string_view prefix1, postfix1;
+    string_view prefix2, postfix2;
     CheckType checkType;
     
     // FISRST OPERAND
     
-    if (IS_SYM(symQUOTE))
+    if (IS_QUOTED_TEXT())
     {
         prefix1 = QUOTED_TEXT();
         SYM(symPLUS);
     }
     SYM(symHASH);
-    string variableId1 = TXT();
+    SymbolId variableId1 = TXT();
     SYM(symDOT);
-    string attributeName1 = TXT();
+    string attributeName1(Symbols::Name(TXT()));
     if (IS_SYM(symPLUS))
     {
         SYM(symPLUS);
@@ -835,15 +1152,15 @@ OP_PTR LangParser::Parse_CompareAttribute()
 
     // SECOND OPERAND
     
-    if (IS_SYM(symQUOTE))
+    if (IS_QUOTED_TEXT())
     {
         prefix2 = QUOTED_TEXT();
         SYM(symPLUS);
     }
     SYM(symHASH);
-    string variableId2 = TXT();
+    SymbolId variableId2 = TXT();
     SYM(symDOT);
-    string attributeName2 = TXT();
+    string attributeName2(Symbols::Name(TXT()));
     if (IS_SYM(symPLUS))
     {
         SYM(symPLUS);
@@ -852,11 +1169,8 @@ OP_PTR LangParser::Parse_CompareAttribute()
        
     _TRACE_("        prefix1 = " << prefix1 << " postfix1 = " << postfix1 << endl);
     _TRACE_("        prefix2 = " << prefix2 << " postfix2 = " << postfix2 << endl);
-    auto p = new CompareAttribute( // must use new ... shared_ptr doesn_t work with 9 parameters
+    return New<CompareAttribute>(
         variableId1, attributeName1, prefix1, postfix1,
         variableId2, attributeName2, prefix2, postfix2,
-        checkType, idTok);
-    shared_ptr<CompareAttribute> res(p);
-
-    return res;
+        checkType, Locate(idTok));
 }
\ No newline at end of file
@@ -1,77 +1,70 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "operations.h"
 #include "token_manager.h"
-#include "../include/script_interpreter.h"
+#include "symbols.h"
 
 
-//SYMBOLS
-const std::string symFOR("FOR");
-const std::string symIN("IN");
-const std::string symWHILE("WHILE");
-const std::string symIF("IF");
-const std::string symTHEN("THEN");
-const std::string symELSE("ELSE");
-const std::string symEND("END");
-const std::string symOR("OR");
-const std::string symAND("AND");
-const std::string symNOT("NOT");
-const std::string symGET_NODES_OF_TYPE("GET_NODES_OF_TYPE");
-const std::string symCONDITIONS_OF("CONDITIONS_OF");
-const std::string symPARENT("PARENT");
-const std::string symPRINT("PRINT");
-const std::string symPRINTS("PRINTS");
-const std::string symENDL("endl");
-const std::string symFALSE("FALSE");
-const std::string symTRUE("TRUE");
-const std::string symNULL("NULL");
-const std::string symSTARTS_WITH("StartsWith");
-const std::string symENDS_WITH("EndsWith");
-const std::string symCONTAINS("Contains");
-// DELIMITERS
-const std::string symHASH("#");
-const std::string symAT("@");
-const std::string symCOLON(":");
-const std::string symSEMICOLON(";");
-const std::string symEQUAL("=");
-const std::string symLOWER("<");
-const std::string symGREATER(">");
-const std::string symPLUS("+");
-const std::string symDOT(".");
-const std::string symCOMMA(",");
-const std::string symQUOTE("\"");
-const std::string symROUNDOPEN("(");
-const std::string symROUNDCLOSE(")");
-const std::string symSPACE(" ");
+struct ParseResult
+{
+    std::string path;
+    uint64_t hash;                      // SourceFile::Hash of the parsed text
+    uint64_t stamp = 0;                 // SourceFile::Stamp when the file was loaded, 0 if unknown
+    std::vector<FUNC_PTR> functions;    // functions parsed before an error are kept
+    std::string error;                  // empty if the whole file was parsed
+    std::vector<std::string> imports;   // paths of the IMPORTed modules, relative ones resolved against the file's folder
+    bool module = false;                // loaded because it was IMPORTed (see ModuleCache)
+};
 
-class LangParser
+struct SplitResult
 {
-    typedef OP_PTR(LangParser::*OpParserFunc)();   // Function pointer
+    std::vector<SourceRange> definitions;   // from '@' up to and including the closing END
+    std::string error;                      // empty if the whole range was split
+    bool truncated = false;                 // the range ended inside a definition (e.g. its END is missing)
+    std::vector<std::string> imports;       // as in ParseResult
+};
 
+class LangParser
+{
 public:
     LangParser();
     
-    std::vector<FUNC_PTR> parse(std::string ruleFilePath);
+    // does not write to the console, safe to run one parser per thread
+    // lazy: only the function headers are parsed, each body is parsed the first time the function is used
+    // threads > 1: a large file is split at the function definitions and the parts are parsed in parallel
+    // (not when lazy), the result is the same as for a serial parse
+    ParseResult parse(std::string ruleFilePath, bool lazy = false, unsigned int threads = 1);
+    ParseResult parse(SOURCE_PTR source, bool lazy = false, unsigned int threads = 1);
+    ParseResult parse(SOURCE_PTR source, SourceRange range, bool lazy = false);   // the definitions in a part of the source
+
+    // finds the function definitions of a part of the source, only the headers are parsed
+    SplitResult split(SOURCE_PTR source, SourceRange range);
+
+    // the operations are allocated in the arena of the function, error is empty if the body was parsed
+    OpList parseBody(SOURCE_PTR source, SourceRange body, OperationArena& arena, std::string& error);
 
 private:
+    ParseResult parseParts(SOURCE_PTR source, bool lazy, unsigned int threads);
 
-    OP_PTR Try(OpParserFunc func);
-    
-    bool        IS_SYM(std::string sym, bool skipSpaces = true);
-    void        SYM(std::string sym);
-    int         NUM();
-    std::string TXT();
-    std::string ANY();
-    std::string QUOTED_TEXT();
+    bool        IS_SYM(Symbol sym);
+    bool        IS_SYM_AT(unsigned int ahead, Symbol sym);
+    bool        IS_QUOTED_TEXT();
+    void        SYM(Symbol sym);
+    std::string_view NUM();
+    SymbolId    TXT();
+    std::string_view QUOTED_TEXT();
+    SourceRange SKIP_BODY(const Token& colon);
 
 private:
-    OP_PTR Parse_FunctionDefinition();
+    std::string Parse_Import();
+    FUNC_PTR Parse_FunctionDefinition();
     OP_PTR Parse_FunctionSetReturnValue();
     std::vector<OP_PTR> Parse_EmbeddedOperations();
 
-    std::vector<std::string> Parse_FnDefinitionParameters();
+    std::vector<SymbolId> Parse_FnDefinitionParameters();
     std::vector<OP_PTR> Parse_FnCallParameters();
     
     OP_PTR Parse_Operation();
@@ -97,6 +90,7 @@ private:
     OP_PTR Parse_TRUE();
     OP_PTR Parse_FALSE();
     OP_PTR Parse_ValueExpression();
+    OP_PTR Parse_HashExpression();  // expressions starting with #
     OP_PTR Parse_Parent();
     OP_PTR Parse_BoolValue();
     /////////////////////////////////////////////////////
@@ -106,7 +100,13 @@ private:
     OP_PTR Parse_PRINT();    
     OP_PTR Parse_PRINTS();
     
+    template<class T, class... Args>
+    OP_PTR New(Args&&... args) { return arena->New<T>(std::forward<Args>(args)...); }
+    const TokenInfo& Locate(const TokenInfo& location) { return arena->Locate(location); }
+    OpList List(const std::vector<OP_PTR>& ops) { return arena->List(ops); }
+
 private:
-    std::vector<std::string> delimiters;
     TokenManager tm;
+    bool lazy;
+    OperationArena* arena;      // of the function being parsed
 };
@@ -48,6 +48,21 @@ public:
         msg = ss.str();
     };
 
+    const char * what() const throw ()
+    {
+        return msg.c_str();
+    }
+};
+
+
+
+class ImageException : public std::exception
+{
+private:
+    std::string msg;
+public:
+    ImageException(std::string message) : msg(message) {};
+
     const char * what() const throw ()
     {
         return msg.c_str();
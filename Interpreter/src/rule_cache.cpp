@@ -0,0 +1,657 @@
+#include "rule_cache.h"
+#include "parser_exceptions.h"
+#include "operation_exceptions.h"
+#include "utils.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+    const char MAGIC[4] = { 'R', 'L', 'C', 'I' };
+    const char* const IMAGE_EXTENSION = ".rlc";
+
+    // the fewest bytes an element of a counted list takes in an image
+    const size_t STR_SIZE = 4;                  // u32:length
+    const size_t SYM_SIZE = 4;                  // u32:index
+    const size_t OP_SIZE = 1 + STR_SIZE + 4;    // u8:OpTag str:token u32:line
+    const size_t FILE_SIZE = STR_SIZE + 8 + 4 + 4;
+
+    // the value of a comparison with a number, as LangParser::NUM accepts it
+    bool IsNumber(string_view text)
+    {
+        if (text.empty() || !all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) return false;
+
+        try { stoi(string(text)); }
+        catch (const out_of_range&) { return false; }
+        return true;
+    }
+}
+
+
+string RuleCache::ImagePath(const string& ruleFilePath, const string& directory)
+{
+    if (directory.empty())
+    {
+        return ruleFilePath + IMAGE_EXTENSION;
+    }
+
+    // rule files with the same name in different folders share the cache directory,
+    // so the name of the image carries the hash of the full path
+    size_t slash = ruleFilePath.find_last_of("\\/");
+    string name = (slash == string::npos) ? ruleFilePath : ruleFilePath.substr(slash + 1);
+
+    stringstream ss;
+    ss << directory;
+    if (directory.back() != '\\' && directory.back() != '/') ss << '\\';
+    ss << name << '.' << hex << setw(16) << setfill('0') << SourceFile::Hash(ruleFilePath) << IMAGE_EXTENSION;
+
+    return ss.str();
+}
+
+void RuleCache::Write(const string& imagePath, const vector<ParseResult>& files)
+{
+    ImageWriter body;
+
+    body.U32((uint32_t)files.size());
+    for (auto& file : files)
+    {
+        body.Str(file.path);
+        body.U64(file.hash);
+        body.U32((uint32_t)file.imports.size());
+        for (auto& import : file.imports)
+        {
+            body.Str(import);
+        }
+        body.U32((uint32_t)file.functions.size());
+        for (auto& func : file.functions)
+        {
+            body.Op(func.get());
+        }
+    }
+
+    ImageWriter header;
+
+    for (char c : MAGIC) header.U8(c);
+    header.U32(VERSION);
+    header.U32((uint32_t)body.UsedSymbols().size());
+    for (SymbolId id : body.UsedSymbols())
+    {
+        header.Str(Symbols::Name(id));
+    }
+
+    // written next to the target and moved over it, so a reader never maps a half written image
+    string tmpPath = imagePath + ".tmp";
+    {
+        ofstream ofs(tmpPath, ios::out | ios::binary | ios::trunc);
+        if (!ofs.is_open() || !ofs.good())
+        {
+            stringstream ss;
+            ss << "Could not create file: " << tmpPath;
+            throw invalid_argument(ss.str().c_str());
+        }
+
+        ofs.write(header.Data().data(), header.Data().size());
+        ofs.write(body.Data().data(), body.Data().size());
+
+        if (!ofs.good())
+        {
+            stringstream ss;
+            ss << "Could not write file: " << tmpPath;
+            throw invalid_argument(ss.str().c_str());
+        }
+    }
+
+    if (!MoveFileExA(tmpPath.c_str(), imagePath.c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+        DeleteFileA(tmpPath.c_str());
+
+        stringstream ss;
+        ss << "Could not replace file: " << imagePath;
+        throw invalid_argument(ss.str().c_str());
+    }
+}
+
+vector<ParseResult> RuleCache::Read(SOURCE_PTR image)
+{
+    try
+    {
+        ImageReader reader(image);
+        return reader.Files();
+    }
+    catch (const OperationBugException&) // operation constructors reject inconsistent trees
+    {
+        stringstream ss;
+        ss << "Corrupt rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////
+// ImageWriter
+
+void ImageWriter::U8(uint8_t val)
+{
+    data.push_back(static_cast<char>(val));
+}
+
+void ImageWriter::U32(uint32_t val)
+{
+    for (int i = 0; i < 4; i++) data.push_back(static_cast<char>((val >> (8 * i)) & 0xFF));
+}
+
+void ImageWriter::U64(uint64_t val)
+{
+    for (int i = 0; i < 8; i++) data.push_back(static_cast<char>((val >> (8 * i)) & 0xFF));
+}
+
+void ImageWriter::Str(string_view str)
+{
+    U32((uint32_t)str.size());
+    data.append(str.data(), str.size());
+}
+
+void ImageWriter::Sym(SymbolId id)
+{
+    auto it = symbolIndex.find(id);
+    if (it == symbolIndex.end())
+    {
+        it = symbolIndex.emplace(id, (uint32_t)symbols.size()).first;
+        symbols.push_back(id);
+    }
+
+    U32(it->second);
+}
+
+void ImageWriter::Syms(const vector<SymbolId>& ids)
+{
+    U32((uint32_t)ids.size());
+    for (SymbolId id : ids) Sym(id);
+}
+
+void ImageWriter::Tok(OpTag tag, const TokenInfo& tok)
+{
+    U8(static_cast<uint8_t>(tag));
+    Str(tok.tok);
+    U32((uint32_t)tok.line);
+}
+
+void ImageWriter::Op(const OP_PTR& op)
+{
+    op->Serialize(*this);
+}
+
+void ImageWriter::Ops(const OpList& ops)
+{
+    U32((uint32_t)ops.size());
+    for (auto& op : ops) Op(op);
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////
+// ImageReader
+
+ImageReader::ImageReader(SOURCE_PTR img)
+    : image(img), data(img->Text()), pos(0), arena(nullptr)
+{
+    for (char c : MAGIC)
+    {
+        if (U8() != static_cast<uint8_t>(c))
+        {
+            stringstream ss;
+            ss << "Not a rule image: " << image->Path();
+            throw ImageException(ss.str().c_str());
+        }
+    }
+
+    uint32_t version = U32();
+    if (version != RuleCache::VERSION)
+    {
+        stringstream ss;
+        ss << "Rule image version " << version << " instead of " << RuleCache::VERSION << ": " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    uint32_t count = Count(STR_SIZE);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        symbols.push_back(Symbols::Intern(Str()));
+    }
+}
+
+uint8_t ImageReader::U8()
+{
+    if (pos + 1 > data.size())
+    {
+        stringstream ss;
+        ss << "Truncated rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    return static_cast<uint8_t>(data[pos++]);
+}
+
+uint32_t ImageReader::U32()
+{
+    uint32_t val = 0;
+    for (int i = 0; i < 4; i++) val |= static_cast<uint32_t>(U8()) << (8 * i);
+    return val;
+}
+
+uint64_t ImageReader::U64()
+{
+    uint64_t val = 0;
+    for (int i = 0; i < 8; i++) val |= static_cast<uint64_t>(U8()) << (8 * i);
+    return val;
+}
+
+uint32_t ImageReader::Count(size_t elementSize)
+{
+    uint32_t count = U32();
+
+    // a corrupt count is caught before a list of its size is allocated
+    if (count > (data.size() - pos) / elementSize)
+    {
+        stringstream ss;
+        ss << "Count " << count << " larger than the rest of the rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    return count;
+}
+
+string_view ImageReader::Str()
+{
+    uint32_t length = U32();
+
+    if (length > data.size() - pos)
+    {
+        stringstream ss;
+        ss << "Truncated rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    string_view str = data.substr(pos, length);
+    pos += length;
+    return str;
+}
+
+SymbolId ImageReader::Sym()
+{
+    uint32_t index = U32();
+
+    if (index >= symbols.size())
+    {
+        stringstream ss;
+        ss << "Symbol index " << index << " out of range in rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    return symbols[index];
+}
+
+vector<SymbolId> ImageReader::Syms()
+{
+    vector<SymbolId> ids(Count(SYM_SIZE));
+    for (auto& id : ids) id = Sym();
+    return ids;
+}
+
+TokenInfo ImageReader::Tok()
+{
+    string_view tok = Str();
+    int line = (int)U32();
+    return { tok, line };
+}
+
+CheckType ImageReader::Check()
+{
+    uint8_t check = U8();
+
+    if (check > GE)
+    {
+        stringstream ss;
+        ss << "Unknown check type " << (unsigned int)check << " in rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    return static_cast<CheckType>(check);
+}
+
+OpList ImageReader::Ops()
+{
+    uint32_t count = Count(OP_SIZE);
+
+    vector<OP_PTR> ops;
+    for (uint32_t i = 0; i < count; i++) ops.push_back(Op());
+    return arena->List(ops);
+}
+
+FUNC_PTR ImageReader::Definition()
+{
+    auto functionArena = make_unique<OperationArena>();
+    arena = functionArena.get();
+
+    OpTag tag = static_cast<OpTag>(U8());
+    TokenInfo t = Tok();
+
+    if (tag != OpTag::FUNCTION)
+    {
+        stringstream ss;
+        ss << "Function expected in rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    SymbolId id = Sym();
+    bool alwaysRuns = U8() != 0;
+    auto params = Syms();
+    auto ops = Ops();
+
+    auto func = make_shared<Function>(id, ops, params, t, image, move(functionArena));
+    if (alwaysRuns) func->SetVolatile();
+    return func;
+}
+
+OP_PTR ImageReader::Op()
+{
+    OpTag tag = static_cast<OpTag>(U8());
+    const TokenInfo& t = arena->Locate(Tok());
+
+    switch (tag)
+    {
+    case OpTag::FUNCTION_CALL:
+    {
+        SymbolId id = Sym();
+        auto params = Ops();
+        return arena->New<FunctionCall>(id, params, t);
+    }
+    case OpTag::SET_FUNCTION_VALUE:
+    {
+        SymbolId id = Sym();
+        OP_PTR op = Op();
+        return arena->New<SetFunctionValue>(id, op, t);
+    }
+    case OpTag::CONDITIONAL_BLOCK:
+    {
+        auto sBlocks = Ops();
+        auto pBlocks = Ops();
+        if (sBlocks.empty() && pBlocks.empty()) return arena->New<ConditionalBlock>(t);
+        return arena->New<ConditionalBlock>(sBlocks, pBlocks, t);
+    }
+    case OpTag::IF_STMT:
+    {
+        OP_PTR cond = Op();
+        auto thanOps = Ops();
+        auto elseOps = Ops();
+        return arena->New<IfStmt>(cond, thanOps, elseOps, t);
+    }
+    case OpTag::WHILE_LOOP:
+    {
+        OP_PTR cond = Op();
+        auto ops = Ops();
+        return arena->New<WhileLoop>(cond, ops, t);
+    }
+    case OpTag::FOR_LOOP:
+    {
+        SymbolId id = Sym();
+        OP_PTR dataGetter = Op();
+        auto ops = Ops();
+        return arena->New<ForLoop>(id, dataGetter, ops, t);
+    }
+    case OpTag::VARIABLE:
+        return arena->New<Variable>(Sym(), t);
+    case OpTag::VARIABLE_ASSIGNMENT:
+    {
+        SymbolId id = Sym();
+        OP_PTR valueGetter = Op();
+        return arena->New<VariableAssignment>(id, valueGetter, t);
+    }
+    case OpTag::NOT:
+        return arena->New<NOT>(Op(), t);
+    case OpTag::TRUE_VAL:
+        return arena->New<TRUE_VAL>(t);
+    case OpTag::FALSE_VAL:
+        return arena->New<FALSE_VAL>(t);
+    case OpTag::NULL_CHECK:
+        return arena->New<NullCheck>(Sym(), t);
+    case OpTag::PRINTS:
+        return arena->New<PRINTS>(string(Str()), t);
+    case OpTag::PRINT:
+        return arena->New<PRINT>(Op(), t);
+    case OpTag::CONDITIONS_OF:
+        return arena->New<CONDITIONS_OF>(Op(), t);
+    case OpTag::PARENT:
+        return arena->New<PARENT>(Op(), t);
+    case OpTag::GET_NODES_OF_TYPE:
+        return arena->New<GET_NODES_OF_TYPE>(string(Str()), t);
+    case OpTag::ATTRIBUTE_CHECK:
+    {
+        SymbolId varId = Sym();
+        string attributeName(Str());
+        string_view attributeValue = Str();
+        CheckType checkType = Check();
+
+        if (checkType >= LT && !IsNumber(attributeValue))
+        {
+            stringstream ss;
+            ss << "Number expected in rule image: " << image->Path();
+            throw ImageException(ss.str().c_str());
+        }
+
+        return arena->New<AttributeCheck>(varId, attributeName, attributeValue, checkType, t);
+    }
+    case OpTag::COMPARE_ATTRIBUTE:
+    {
+        SymbolId varId1 = Sym();
+        string attributeName1(Str());
+        string_view prefix1 = Str();
+        string_view postfix1 = Str();
+        SymbolId varId2 = Sym();
+        string attributeName2(Str());
+        string_view prefix2 = Str();
+        string_view postfix2 = Str();
+        CheckType checkType = Check();
+        return arena->New<CompareAttribute>(
+            varId1, attributeName1, prefix1, postfix1,
+            varId2, attributeName2, prefix2, postfix2,
+            checkType, t);
+    }
+    default:
+        break;
+    }
+
+    stringstream ss;
+    ss << "Unknown operation " << (unsigned int)tag << " in rule image: " << image->Path();
+    throw ImageException(ss.str().c_str());
+}
+
+vector<ParseResult> ImageReader::Files()
+{
+    vector<ParseResult> files(Count(FILE_SIZE));
+
+    for (auto& file : files)
+    {
+        file.path = string(Str());
+        file.hash = U64();
+
+        uint32_t imports = Count(STR_SIZE);
+        for (uint32_t i = 0; i < imports; i++)
+        {
+            file.imports.push_back(string(Str()));
+        }
+
+        uint32_t count = Count(OP_SIZE);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            file.functions.push_back(Definition());
+        }
+    }
+
+    if (pos != data.size())
+    {
+        stringstream ss;
+        ss << "Unexpected data at the end of rule image: " << image->Path();
+        throw ImageException(ss.str().c_str());
+    }
+
+    return files;
+}
+
+
+
+/////////////////////////////////////////////////////////////////////////////////
+// Operation::Serialize, fields in the order ImageReader::Op reads them
+
+void Function::Serialize(ImageWriter & out) const
+{
+    string error = Validate(); // a lazily loaded body is parsed now
+    if (!error.empty())
+    {
+        throw invalid_argument(error.c_str());
+    }
+
+    out.Tok(OpTag::FUNCTION, t);
+    out.Sym(id);
+    out.U8(isVolatile ? 1 : 0);
+    out.Syms(parameters);
+    out.Ops(operations);
+}
+
+void FunctionCall::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::FUNCTION_CALL, t);
+    out.Sym(id);
+    out.Ops(parameters);
+}
+
+void SetFunctionValue::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::SET_FUNCTION_VALUE, t);
+    out.Sym(functionId);
+    out.Op(op);
+}
+
+void ConditionalBlock::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::CONDITIONAL_BLOCK, t);
+    out.Ops(sBlocks);
+    out.Ops(pBlocks);
+}
+
+void IfStmt::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::IF_STMT, t);
+    out.Op(condition);
+    out.Ops(thanOperations);
+    out.Ops(elseOperations);
+}
+
+void WhileLoop::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::WHILE_LOOP, t);
+    out.Op(condition);
+    out.Ops(operations);
+}
+
+void ForLoop::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::FOR_LOOP, t);
+    out.Sym(id);
+    out.Op(dataGetter);
+    out.Ops(operations);
+}
+
+void Variable::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::VARIABLE, t);
+    out.Sym(id);
+}
+
+void VariableAssignment::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::VARIABLE_ASSIGNMENT, t);
+    out.Sym(id);
+    out.Op(valueGetter);
+}
+
+void NOT::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::NOT, t);
+    out.Op(expression);
+}
+
+void TRUE_VAL::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::TRUE_VAL, t);
+}
+
+void FALSE_VAL::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::FALSE_VAL, t);
+}
+
+void NullCheck::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::NULL_CHECK, t);
+    out.Sym(varId);
+}
+
+void PRINTS::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::PRINTS, t);
+    out.Str(msg);
+}
+
+void PRINT::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::PRINT, t);
+    out.Op(operation);
+}
+
+void CONDITIONS_OF::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::CONDITIONS_OF, t);
+    out.Op(operation);
+}
+
+void PARENT::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::PARENT, t);
+    out.Op(operation);
+}
+
+void GET_NODES_OF_TYPE::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::GET_NODES_OF_TYPE, t);
+    out.Str(typeName);
+}
+
+void AttributeCheck::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::ATTRIBUTE_CHECK, t);
+    out.Sym(varId);
+    out.Str(attributeId);
+    out.Str(attribVal);
+    out.U8(static_cast<uint8_t>(checkType));
+}
+
+void CompareAttribute::Serialize(ImageWriter & out) const
+{
+    out.Tok(OpTag::COMPARE_ATTRIBUTE, t);
+    out.Sym(varId1);
+    out.Str(attributeId1);
+    out.Str(prefix1);
+    out.Str(postfix1);
+    out.Sym(varId2);
+    out.Str(attributeId2);
+    out.Str(prefix2);
+    out.Str(postfix2);
+    out.U8(static_cast<uint8_t>(checkType));
+}
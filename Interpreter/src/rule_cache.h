@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "operations.h"
+#include "parser.h"
+#include "source_file.h"
+#include "symbols.h"
+
+// Compiled rule images
+// ====================
+// An image is a binary snapshot of parsed rule files: for every file its path, the hash of the
+// parsed text and the operation trees of its functions. The cache image of one rule file and the
+// bundle of a whole rule set have the same format.
+//
+// Layout (little endian, no pointers, so the image can be mapped at any address):
+//      "RLCI" u32:version
+//      u32:symbolCount { str:name }                  identifiers, referenced by index
+//      u32:fileCount   { str:path u64:hash u32:importCount { str:path } u32:functionCount { op } }
+//  op  = u8:OpTag str:token u32:line <operation specific fields>
+//  str = u32:length <bytes>
+//
+// Strings are not copied when an image is read: token texts and literals of the operations are
+// views into the mapped image, which is kept alive by the functions (Function::source).
+
+namespace RuleCache
+{
+    const uint32_t VERSION = 3;
+
+    // where Load keeps the image of a rule file: next to it if directory is empty
+    std::string ImagePath(const std::string& ruleFilePath, const std::string& directory);
+
+    void Write(const std::string& imagePath, const std::vector<ParseResult>& files); // throws invalid_argument if the image cannot be written or a lazy body has errors
+    std::vector<ParseResult> Read(SOURCE_PTR image);                                  // throws ImageException if the image is not valid
+}
+
+enum class OpTag : uint8_t
+{
+    FUNCTION = 1,
+    FUNCTION_CALL,
+    SET_FUNCTION_VALUE,
+    CONDITIONAL_BLOCK,
+    IF_STMT,
+    WHILE_LOOP,
+    FOR_LOOP,
+    VARIABLE,
+    VARIABLE_ASSIGNMENT,
+    NOT,
+    TRUE_VAL,
+    FALSE_VAL,
+    NULL_CHECK,
+    PRINTS,
+    PRINT,
+    CONDITIONS_OF,
+    PARENT,
+    GET_NODES_OF_TYPE,
+    ATTRIBUTE_CHECK,
+    COMPARE_ATTRIBUTE
+};
+
+class ImageWriter
+{
+private:
+    std::string data;
+    std::vector<SymbolId> symbols;
+    std::unordered_map<SymbolId, uint32_t> symbolIndex;
+public:
+    void U8(uint8_t val);
+    void U32(uint32_t val);
+    void U64(uint64_t val);
+    void Str(std::string_view str);
+    void Sym(SymbolId id);
+    void Syms(const std::vector<SymbolId>& ids);
+    void Tok(OpTag tag, const TokenInfo& tok);     // header of every operation
+    void Op(const OP_PTR& op);
+    void Ops(const OpList& ops);
+
+    const std::string& Data() const { return data; }
+    const std::vector<SymbolId>& UsedSymbols() const { return symbols; }
+};
+
+class ImageReader
+{
+private:
+    SOURCE_PTR image;
+    std::string_view data;
+    size_t pos;
+    std::vector<SymbolId> symbols;
+    OperationArena* arena;      // of the function being read
+public:
+    ImageReader(SOURCE_PTR image);
+
+    uint8_t U8();
+    uint32_t U32();
+    uint64_t U64();
+    uint32_t Count(size_t elementSize);     // of a list, checked against the bytes left; elementSize: fewest bytes of an element
+    std::string_view Str();
+    SymbolId Sym();
+    std::vector<SymbolId> Syms();
+    TokenInfo Tok();
+    CheckType Check();
+    FUNC_PTR Definition();     // a function with its operations in a new arena
+    OP_PTR Op();
+    OpList Ops();
+
+    std::vector<ParseResult> Files();
+};
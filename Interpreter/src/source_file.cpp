@@ -0,0 +1,117 @@
+#include "source_file.h"
+#include "utils.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+SourceFile::SourceFile(string filePath)
+    : path(filePath), data(""), size(0), view(0)
+{
+}
+
+SourceFile::~SourceFile()
+{
+    if (view)
+    {
+        UnmapViewOfFile(view);
+    }
+}
+
+shared_ptr<const SourceFile> SourceFile::Open(string path)
+{
+    shared_ptr<SourceFile> file(new SourceFile(path));
+
+    file->Map();
+
+    if (!file->view)
+    {
+        file->Read(); // mapping is not possible (e.g. empty file, or open for writing) ... fall back to reading it
+    }
+
+    return file;
+}
+
+shared_ptr<const SourceFile> SourceFile::FromText(string path, string text)
+{
+    shared_ptr<SourceFile> file(new SourceFile(path));
+
+    file->buffer = move(text);
+    file->data = file->buffer.data();
+    file->size = file->buffer.size();
+
+    return file;
+}
+
+uint64_t SourceFile::Hash(string_view text)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : text)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t SourceFile::Stamp(const string& path)
+{
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes))
+    {
+        return 0;
+    }
+
+    return (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+}
+
+void SourceFile::Map()
+{
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0 && (unsigned long long)fileSize.QuadPart <= 0xFFFFFFFFull)
+    {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps the mapping alive
+
+            if (view)
+            {
+                data = static_cast<const char*>(view);
+                size = static_cast<size_t>(fileSize.QuadPart);
+            }
+        }
+    }
+
+    CloseHandle(file);
+}
+
+void SourceFile::Read()
+{
+    ifstream ifs(path, ios::in | ios::binary);
+
+    if (!ifs.is_open() || !ifs.good())
+    {
+        stringstream ss;
+        ss << "Could not open file: " << path;
+        throw invalid_argument(ss.str().c_str());
+    }
+
+    stringstream ss;
+    ss << ifs.rdbuf();
+    buffer = ss.str();
+
+    data = buffer.data();
+    size = buffer.size();
+}
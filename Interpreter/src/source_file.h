@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <cstdint>
+
+// Read-only contents of a rule file. The file is memory mapped when possible, otherwise it is read
+// into a buffer. Tokens and parsed operations keep views into the contents, so the SourceFile must
+// outlive them: parsed Function objects and the function tables of a load hold a SOURCE_PTR.
+// A mapped file is not shared for writing, so nothing changes the bytes under the views of loaded
+// functions: an editor that saves the file in place gets a sharing violation while its functions are
+// loaded. A file that is open for writing when it is loaded is read instead.
+class SourceFile
+{
+private:
+    std::string path;
+    const char* data;
+    size_t size;
+    void* view;             // mapped view, null when the buffered fallback is used
+    std::string buffer;     // buffered fallback
+
+private:
+    SourceFile(std::string path);
+    void Map();
+    void Read();
+
+public:
+    ~SourceFile();
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    static std::shared_ptr<const SourceFile> Open(std::string path);
+    static std::shared_ptr<const SourceFile> FromText(std::string path, std::string text);   // e.g. unsaved editor contents
+
+    const std::string& Path() const { return path; }
+    std::string_view Text() const { return std::string_view(data, size); }
+    bool IsMapped() const { return view != 0; }
+    uint64_t Hash() const { return Hash(Text()); }   // identifies the parsed text in rule cache images
+
+    static uint64_t Hash(std::string_view text);    // FNV-1a
+    static uint64_t Stamp(const std::string& path); // last write time, 0 if the file does not exist
+};
+
+typedef std::shared_ptr<const SourceFile> SOURCE_PTR;
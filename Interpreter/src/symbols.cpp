@@ -0,0 +1,291 @@
+#include "symbols.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+    const string_view SYMBOL_NAMES[symFIRST_IDENTIFIER] =
+    {
+        "",
+        "FOR", "IN", "WHILE", "IF", "THEN", "ELSE", "END", "OR", "AND", "NOT",
+        "GET_NODES_OF_TYPE", "CONDITIONS_OF", "PARENT", "PRINT", "PRINTS", "endl",
+        "FALSE", "TRUE", "NULL", "StartsWith", "EndsWith", "Contains", "IMPORT", "VOLATILE",
+        "#", "@", ":", ";", "=", "<", ">", "+", ".", ",", "\"", "(", ")"
+    };
+
+    const Symbol FIRST_KEYWORD = symFOR;
+    const Symbol LAST_KEYWORD = symVOLATILE;
+    const Symbol FIRST_DELIMITER = symHASH;
+
+    /////////////////////////////////////////////////////////////////////////////////
+    // Perfect hash over the keyword set, checked at compile time
+
+    constexpr string_view KEYWORDS[] =
+    {
+        "FOR", "IN", "WHILE", "IF", "THEN", "ELSE", "END", "OR", "AND", "NOT",
+        "GET_NODES_OF_TYPE", "CONDITIONS_OF", "PARENT", "PRINT", "PRINTS", "endl",
+        "FALSE", "TRUE", "NULL", "StartsWith", "EndsWith", "Contains", "IMPORT", "VOLATILE"
+    };
+
+    const unsigned int KEYWORD_TABLE_SIZE = 64;
+
+    constexpr unsigned int KeywordHash(string_view s)
+    {
+        return (static_cast<unsigned int>(s.size())
+            + 2 * static_cast<unsigned char>(s.front())
+            + 23 * static_cast<unsigned char>(s.back())) & (KEYWORD_TABLE_SIZE - 1);
+    }
+
+    struct KeywordTable
+    {
+        Symbol slot[KEYWORD_TABLE_SIZE];
+        bool perfect;
+
+        constexpr KeywordTable() : slot(), perfect(true)
+        {
+            for (unsigned int i = 0; i < KEYWORD_TABLE_SIZE; i++) slot[i] = symNONE;
+
+            for (unsigned int k = 0; k < sizeof(KEYWORDS) / sizeof(KEYWORDS[0]); k++)
+            {
+                unsigned int h = KeywordHash(KEYWORDS[k]);
+                if (slot[h] != symNONE) perfect = false;
+                slot[h] = static_cast<Symbol>(FIRST_KEYWORD + k);
+            }
+        }
+    };
+
+    constexpr KeywordTable keywordTable;
+
+    static_assert(keywordTable.perfect, "Keyword hash has collisions, change the KeywordHash constants!");
+    static_assert(sizeof(KEYWORDS) / sizeof(KEYWORDS[0]) == LAST_KEYWORD - FIRST_KEYWORD + 1, "KEYWORDS out of sync with Symbol");
+
+    struct DelimiterTable
+    {
+        Symbol sym[256];
+
+        constexpr DelimiterTable() : sym()
+        {
+            const char delimiters[] = "#@:;=<>+.,\"()"; // same order as the DELIMITERS of Symbol
+            for (unsigned int i = 0; i < 256; i++) sym[i] = symNONE;
+            for (unsigned int i = 0; delimiters[i]; i++) sym[static_cast<unsigned char>(delimiters[i])] = static_cast<Symbol>(FIRST_DELIMITER + i);
+        }
+    };
+
+    constexpr DelimiterTable delimiterTable;
+
+    static_assert(delimiterTable.sym[static_cast<unsigned char>(')')] == symROUNDCLOSE, "Delimiter table out of sync with Symbol");
+
+    /////////////////////////////////////////////////////////////////////////////////
+    // Identifier interning
+
+    class SymbolTable
+    {
+    private:
+        static const unsigned int CHUNK_BITS = 12;
+        static const unsigned int CHUNK_SIZE = 1 << CHUNK_BITS;
+        static const unsigned int MAX_CHUNKS = 4096;
+
+        shared_mutex mutex;
+        deque<string> storage;                                  // stable addresses for the names
+        unordered_map<string_view, SymbolId> ids;
+        unique_ptr<string_view[]> chunks[MAX_CHUNKS];           // id -> name, never reallocated so Name() does not lock
+        atomic<SymbolId> next;
+
+    public:
+        SymbolTable() : next(symFIRST_IDENTIFIER) {}
+
+        SymbolId Intern(string_view text)
+        {
+            {
+                shared_lock<shared_mutex> lock(mutex);
+                auto it = ids.find(text);
+                if (it != ids.end()) return it->second;
+            }
+
+            unique_lock<shared_mutex> lock(mutex);
+
+            auto it = ids.find(text);
+            if (it != ids.end()) return it->second;
+
+            SymbolId id = next.load(memory_order_relaxed);
+            unsigned int chunk = id >> CHUNK_BITS;
+            if (chunk >= MAX_CHUNKS) throw length_error("Too many identifiers!");
+            if (!chunks[chunk]) chunks[chunk].reset(new string_view[CHUNK_SIZE]);
+
+            storage.emplace_back(text);
+            string_view name(storage.back());
+
+            chunks[chunk][id & (CHUNK_SIZE - 1)] = name;
+            ids.emplace(name, id);
+            next.store(id + 1, memory_order_release);
+
+            return id;
+        }
+
+        SymbolId Find(string_view text)        // symNONE if text is not interned
+        {
+            shared_lock<shared_mutex> lock(mutex);
+            auto it = ids.find(text);
+            return (it != ids.end()) ? it->second : symNONE;
+        }
+
+        string_view Name(SymbolId id) const
+        {
+            if (id >= next.load(memory_order_acquire)) return string_view();
+            return chunks[id >> CHUNK_BITS][id & (CHUNK_SIZE - 1)];
+        }
+
+        static SymbolTable& Instance()
+        {
+            static SymbolTable singleton;
+            return singleton;
+        }
+    };
+
+    thread_local SymbolSession* openSession = nullptr;
+
+    /////////////////////////////////////////////////////////////////////////////////
+    // Live symbol sessions, a session id is symFIRST_SESSION | slot << SESSION_INDEX_BITS | index
+
+    const unsigned int SESSION_INDEX_BITS = 20;
+    const unsigned int MAX_SESSIONS = 1 << 11;
+
+    class SessionList
+    {
+    private:
+        shared_mutex mutex;
+        const SymbolSession* sessions[MAX_SESSIONS] = {};
+        unsigned int next = 0;                  // a slot is reused as late as possible
+
+    public:
+        unsigned int Add(const SymbolSession* session)
+        {
+            unique_lock<shared_mutex> lock(mutex);
+
+            for (unsigned int i = 0; i < MAX_SESSIONS; i++)
+            {
+                unsigned int slot = (next + i) % MAX_SESSIONS;
+                if (sessions[slot]) continue;
+
+                sessions[slot] = session;
+                next = slot + 1;
+                return slot;
+            }
+            throw length_error("Too many symbol sessions!");
+        }
+
+        void Remove(unsigned int slot)          // waits for the Name calls that use the session
+        {
+            unique_lock<shared_mutex> lock(mutex);
+            sessions[slot] = nullptr;
+        }
+
+        string_view Name(SymbolId id)
+        {
+            shared_lock<shared_mutex> lock(mutex);
+            const SymbolSession* session = sessions[((id - symFIRST_SESSION) >> SESSION_INDEX_BITS) % MAX_SESSIONS];
+            return session ? session->Name(id) : string_view();
+        }
+
+        static SessionList& Instance()
+        {
+            static SessionList singleton;
+            return singleton;
+        }
+    };
+}
+
+
+Symbol Symbols::Keyword(string_view text)
+{
+    if (text.empty()) return symNONE;
+
+    Symbol sym = keywordTable.slot[KeywordHash(text)];
+
+    return (sym != symNONE && SYMBOL_NAMES[sym] == text) ? sym : symNONE;
+}
+
+Symbol Symbols::Delimiter(char c)
+{
+    return delimiterTable.sym[static_cast<unsigned char>(c)];
+}
+
+SymbolId Symbols::Intern(string_view text)
+{
+    Symbol sym = Keyword(text);
+    if (sym != symNONE) return sym;
+
+    if (openSession) return openSession->Intern(text);
+
+    return SymbolTable::Instance().Intern(text);
+}
+
+string_view Symbols::Name(SymbolId id)
+{
+    if (id < symFIRST_IDENTIFIER) return SYMBOL_NAMES[id];
+
+    if (id >= symFIRST_SESSION) return SessionList::Instance().Name(id);
+
+    return SymbolTable::Instance().Name(id);
+}
+
+/////////////////////////////////////////////////////////////////////////////////
+// SymbolSession
+
+SymbolSession::SymbolSession()
+    : slot(SessionList::Instance().Add(this))
+{
+}
+
+SymbolSession::~SymbolSession()
+{
+    SessionList::Instance().Remove(slot);
+}
+
+SymbolId SymbolSession::Intern(string_view text)
+{
+    // a name of the loaded rules keeps its id, so the functions of a session call the same ids
+    SymbolId id = SymbolTable::Instance().Find(text);
+    if (id != symNONE) return id;
+
+    auto it = ids.find(text);       // only the thread that has the session open changes it
+    if (it != ids.end()) return it->second;
+
+    unique_lock<shared_mutex> lock(mutex);      // against Name on other threads
+
+    if (names.size() >= (1u << SESSION_INDEX_BITS)) throw length_error("Too many identifiers!");
+
+    id = symFIRST_SESSION | (slot << SESSION_INDEX_BITS) | (SymbolId)names.size();
+    names.emplace_back(text);
+    ids.emplace(names.back(), id);
+
+    return id;
+}
+
+string_view SymbolSession::Name(SymbolId id) const
+{
+    if (id < symFIRST_SESSION || ((id - symFIRST_SESSION) >> SESSION_INDEX_BITS) != slot) return string_view();
+
+    shared_lock<shared_mutex> lock(mutex);
+    size_t index = id & ((1u << SESSION_INDEX_BITS) - 1);
+    return index < names.size() ? string_view(names[index]) : string_view();
+}
+
+void SymbolSession::Open()
+{
+    outer = openSession;
+    openSession = this;
+}
+
+void SymbolSession::Close()
+{
+    openSession = outer;
+    outer = nullptr;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+typedef unsigned int SymbolId;
+
+// Language symbols have fixed ids. Identifiers get ids >= symFIRST_IDENTIFIER when they are interned.
+enum Symbol : SymbolId
+{
+    symNONE = 0,
+    //KEYWORDS
+    symFOR,
+    symIN,
+    symWHILE,
+    symIF,
+    symTHEN,
+    symELSE,
+    symEND,
+    symOR,
+    symAND,
+    symNOT,
+    symGET_NODES_OF_TYPE,
+    symCONDITIONS_OF,
+    symPARENT,
+    symPRINT,
+    symPRINTS,
+    symENDL,
+    symFALSE,
+    symTRUE,
+    symNULL,
+    symSTARTS_WITH,
+    symENDS_WITH,
+    symCONTAINS,
+    symIMPORT,
+    symVOLATILE,
+    // DELIMITERS
+    symHASH,
+    symAT,
+    symCOLON,
+    symSEMICOLON,
+    symEQUAL,
+    symLOWER,
+    symGREATER,
+    symPLUS,
+    symDOT,
+    symCOMMA,
+    symQUOTE,
+    symROUNDOPEN,
+    symROUNDCLOSE,
+
+    symFIRST_IDENTIFIER
+};
+
+const SymbolId symFIRST_SESSION = 0x80000000;  // ids of SymbolSession, above every id of the process wide table
+
+namespace Symbols {
+    Symbol Keyword(std::string_view text);      // symNONE if text is not a keyword
+    Symbol Delimiter(char c);                   // symNONE if c is not a delimiter
+
+    SymbolId Intern(std::string_view text);     // thread safe, ids are stable for the lifetime of the process
+    std::string_view Name(SymbolId id);         // of a session id too, empty once its session is gone
+}
+
+// Identifiers for an editor: while a session is open on a thread, Intern gives the names that are not in the
+// process wide table ids of the session, so the partial names typed between two keystrokes are freed with
+// the session instead of living as long as the process. A session id is >= symFIRST_SESSION and tells its
+// session apart, Name finds it on any thread for as long as the session exists. A FunctionTable does not
+// take functions with session ids, they are for diagnostics.
+class SymbolSession
+{
+private:
+    unsigned int slot;                                  // in the list of live sessions, part of every id
+    mutable std::shared_mutex mutex;                    // Name may run on other threads while a parse interns
+    std::deque<std::string> names;                      // by the index part of the id, stable addresses
+    std::unordered_map<std::string_view, SymbolId> ids;
+    SymbolSession* outer = nullptr;                     // the session open on the thread before this one
+
+public:
+    SymbolSession();        // throws length_error if too many sessions exist
+    ~SymbolSession();
+    SymbolSession(const SymbolSession&) = delete;
+    SymbolSession& operator=(const SymbolSession&) = delete;
+
+    SymbolId Intern(std::string_view text);
+    std::string_view Name(SymbolId id) const;   // empty if the id is not one of this session
+
+    void Open();        // on the calling thread, until Close
+    void Close();
+
+    struct Scope
+    {
+        SymbolSession& session;
+        Scope(SymbolSession& s) : session(s) { session.Open(); }
+        ~Scope() { session.Close(); }
+    };
+};
@@ -1,9 +1,39 @@
 #pragma once
 
-#include <string>
+#include <string_view>
+#include "symbols.h"
 
+enum class TokenKind : unsigned char
+{
+    IDENTIFIER,     // [a-zA-Z0-9_]+
+    NUMBER,         // [0-9]+ (also a valid IDENTIFIER)
+    WORD,           // any other run of non delimiter characters
+    DELIMITER,      // single character delimiter
+    STRING          // quoted text, offset/length exclude the quotes
+};
+
+// Compact lexer token. Refers to a range of the source buffer held by the TokenManager.
+// Keywords and delimiters carry their Symbol, identifiers and numbers their interned id.
 struct Token
 {
-    std::string tok;
+    TokenKind kind;
+    SymbolId sym;
+    unsigned int offset;
+    unsigned int length;
     int line;
-};
\ No newline at end of file
+};
+
+// Token text as a view into the source buffer. Kept by operations for error messages.
+struct TokenInfo
+{
+    std::string_view tok;
+    int line;
+};
+
+// Part of the source buffer, e.g. the body of a function that is parsed on first use
+struct SourceRange
+{
+    unsigned int begin;     // offset of the first character
+    unsigned int end;       // offset past the last character
+    int line;               // line of 'begin'
+};
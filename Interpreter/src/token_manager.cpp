@@ -1,82 +1,68 @@
 #include "token_manager.h"
+#include "tokenizer.h"
 #include "parser_exceptions.h"
 #include <sstream>
 
 using namespace std;
 
 TokenManager::TokenManager()
-    : current(0), backup(0)
+    : current(0), endOfInput({ TokenKind::DELIMITER, symNONE, 0, 0, 0 })
 {
 }
 
-void TokenManager::SetTokens(std::vector<Token> t)
+void TokenManager::SetSource(SOURCE_PTR src)
 {
-    tokens = t;
+    source = src;
+    tokens = Tokenizer::tokenize(source->Text());
     current = 0;
+    endOfInput.line = tokens.empty() ? 0 : tokens.back().line;
 }
 
-Token TokenManager::Current(bool skipSpaces)
+void TokenManager::SetSource(SOURCE_PTR src, SourceRange range)
 {
-    Token t;
-
-    while (skipSpaces && " " == tokens[current].tok && current < tokens.size())
-    {
-        current++;
-    }
+    source = src;
+    tokens = Tokenizer::tokenize(source->Text(), range.begin, range.end, range.line);
+    current = 0;
+    endOfInput.line = tokens.empty() ? range.line : tokens.back().line;
+}
 
-    if (current < tokens.size())
-    {
-        t = tokens[current];
-    }
-    else
+const Token& TokenManager::Current()
+{
+    if (current >= tokens.size())
     {
         stringstream ss;
         ss << "No more tokens available!";
         throw BadSyntaxException(ss.str().c_str());
     }
 
-    return t;
+    return tokens[current];
 }
 
-bool TokenManager::NoMoreTokens(bool skipSpaces)
+TokenInfo TokenManager::CurrentInfo()
 {
-    while (skipSpaces && current < tokens.size() && " " == tokens[current].tok)
-    {
-        current++;
-    }
+    const Token& t = Current();
 
-    return tokens.size()==current;
+    return { Text(t), t.line };
 }
 
-Token TokenManager::GetNext(bool skipSpaces)
+bool TokenManager::NoMoreTokens()
 {
-    Token t;
-
-    while (skipSpaces && current < tokens.size() && " " == tokens[current].tok)
-    {
-        current++;
-    }
+    return tokens.size()==current;
+}
 
-    if (current < tokens.size())
-    {
-        t = tokens[current++];
-    }
-    else
+const Token& TokenManager::GetNext()
+{
+    if (current >= tokens.size())
     {
         stringstream ss;
         ss << "No more tokens available!";
         throw ParseException(ss.str().c_str());
     }
 
-    return t;
-}
-
-void TokenManager::SaveCurrent()
-{
-    backup = current;
+    return tokens[current++];
 }
 
-void TokenManager::RestoreCurrent()
+const Token& TokenManager::Peek(unsigned int ahead)
 {
-    current = backup;
+    return (current + ahead < tokens.size()) ? tokens[current + ahead] : endOfInput;
 }
\ No newline at end of file
@@ -1,21 +1,28 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include "token.h"
+#include "source_file.h"
 
 class TokenManager
 {
 private:
     unsigned int current;
-    unsigned int backup;
+    SOURCE_PTR source;
     std::vector<Token> tokens;    
+    Token endOfInput;           // returned by Peek past the last token
 public:
     TokenManager();
-    void SetTokens(std::vector<Token> tokens);
-    Token Current(bool skipSpaces = true);
-    Token GetNext(bool skipSpaces = true);
-    bool NoMoreTokens(bool skipSpaces = true);
-    void SaveCurrent();
-    void RestoreCurrent();
+    void SetSource(SOURCE_PTR source);
+    void SetSource(SOURCE_PTR source, SourceRange range);   // only the tokens of the range
+    SOURCE_PTR Source() const { return source; }
+    const Token& Current();
+    const Token& GetNext();
+    const Token& Peek(unsigned int ahead);  // Peek(0) is the current token, never throws
+    bool NoMoreTokens();
+
+    std::string_view Text(const Token& t) const { return std::string_view(source->Text().data() + t.offset, t.length); }
+    TokenInfo CurrentInfo();
 };
\ No newline at end of file
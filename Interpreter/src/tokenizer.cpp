@@ -0,0 +1,142 @@
+#include "tokenizer.h"
+#include "parser_exceptions.h"
+#include "symbols.h"
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+    enum CharClass : unsigned char
+    {
+        CC_OTHER,
+        CC_ALPHA,       // letters and '_'
+        CC_DIGIT,
+        CC_SPACE,       // ' ', '\t', '\r'
+        CC_NEWLINE,
+        CC_DELIMITER,
+        CC_QUOTE
+    };
+
+    const char DELIMITER_CHARS[] = "#@:;=<>+.,()"; // see the DELIMITERS section of symbols.h
+    const char COMMENT_CHAR = ';';                  // only when it is the first character of a line
+
+    struct CharClassTable
+    {
+        CharClass cls[256];
+
+        constexpr CharClassTable() : cls()
+        {
+            for (int c = 0; c < 256; c++)
+            {
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_') cls[c] = CC_ALPHA;
+                else if (c >= '0' && c <= '9')                                       cls[c] = CC_DIGIT;
+                else if (c == ' ' || c == '\t' || c == '\r')                           cls[c] = CC_SPACE;
+                else if (c == '\n')                                                    cls[c] = CC_NEWLINE;
+                else if (c == '"')                                                     cls[c] = CC_QUOTE;
+                else                                                                   cls[c] = CC_OTHER;
+            }
+
+            for (const char* d = DELIMITER_CHARS; *d; d++)
+            {
+                cls[static_cast<unsigned char>(*d)] = CC_DELIMITER;
+            }
+        }
+
+        CharClass operator[](char c) const { return cls[static_cast<unsigned char>(c)]; }
+    };
+
+    constexpr CharClassTable charClass;
+
+    static_assert(charClass.cls['#'] == CC_DELIMITER, "delimiter table not set up");
+    static_assert(charClass.cls['x'] == CC_ALPHA, "character table not set up");
+}
+
+
+vector<Token> Tokenizer::tokenize(string_view source)
+{
+    return tokenize(source, 0, source.size(), 1);
+}
+
+vector<Token> Tokenizer::tokenize(string_view source, size_t begin, size_t stop, int firstLine)
+{
+    vector<Token> tokens;
+    tokens.reserve((stop - begin) / 4);
+
+    const char* const src = source.data();
+    const size_t size = stop;
+
+    int line = firstLine;
+    size_t i = begin;
+    bool lineStart = (begin == 0 || src[begin - 1] == '\n');
+
+    while (i < size)
+    {
+        if (lineStart && src[i] == COMMENT_CHAR)
+        {
+            while (i < size && src[i] != '\n') i++;  // skip comment line
+            continue;
+        }
+
+        lineStart = false;
+
+        switch (charClass[src[i]])
+        {
+        case CC_NEWLINE:
+            line++;
+            lineStart = true;
+            i++;
+            break;
+
+        case CC_SPACE:
+            i++;
+            break;
+
+        case CC_DELIMITER:
+            tokens.push_back({ TokenKind::DELIMITER, Symbols::Delimiter(src[i]), (unsigned int)i, 1, line });
+            i++;
+            break;
+
+        case CC_QUOTE:
+        {
+            size_t end = i + 1;
+            while (end < size && src[end] != '"' && src[end] != '\n') end++;
+
+            if (end >= size || src[end] != '"')
+            {
+                stringstream ss;
+                ss << "@line: " << line << " - Missing closing quote.";
+                throw BadSyntaxException(ss.str().c_str());
+            }
+
+            tokens.push_back({ TokenKind::STRING, symNONE, (unsigned int)(i + 1), (unsigned int)(end - i - 1), line });
+            i = end + 1;
+            break;
+        }
+
+        default: // run of letters, digits and other non delimiter characters
+        {
+            TokenKind kind = TokenKind::NUMBER;
+            size_t end = i;
+
+            for (; end < size; end++)
+            {
+                CharClass cls = charClass[src[end]];
+
+                if (cls == CC_DIGIT) continue;
+                else if (cls == CC_ALPHA) { if (kind == TokenKind::NUMBER) kind = TokenKind::IDENTIFIER; }
+                else if (cls == CC_OTHER) { kind = TokenKind::WORD; }
+                else break;
+            }
+
+            SymbolId sym = (kind == TokenKind::WORD) ? symNONE : Symbols::Intern(source.substr(i, end - i));
+
+            tokens.push_back({ kind, sym, (unsigned int)i, (unsigned int)(end - i), line });
+            i = end;
+            break;
+        }
+        }
+    }
+
+    return tokens;
+}
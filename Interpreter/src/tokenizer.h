@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include "token.h"
+
+namespace Tokenizer {
+    std::vector<Token> tokenize(std::string_view source);
+
+    // tokens of source[begin, end), 'line' is the line at 'begin'. Offsets stay relative to the whole source.
+    std::vector<Token> tokenize(std::string_view source, size_t begin, size_t end, int line);
+}
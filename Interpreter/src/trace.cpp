@@ -33,10 +33,17 @@ Trace::Trace()
     }
 }
 
+static thread_local std::stringstream ss;
+
 void Trace::Flush()
 {
-    if (TraceTarget::TRACE_TO_FILE & g_traceConf.target) ofs << ss.str();
-    if (TraceTarget::TRACE_TO_STDOUT & g_traceConf.target) std::cout << ss.str();
+    if (g_traceConf.target)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (TraceTarget::TRACE_TO_FILE & g_traceConf.target) ofs << ss.str();
+        if (TraceTarget::TRACE_TO_STDOUT & g_traceConf.target) std::cout << ss.str();
+    }
 
     ss.str("");         // clear buffer
 }
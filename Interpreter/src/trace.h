@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <mutex>
 
 #define _TRACE_(x) Trace::Instance().getBuffer() << x; Trace::Instance().Flush();
 
@@ -16,7 +17,7 @@ class Trace
 {
 private:
     std::ofstream ofs;
-    std::stringstream ss;
+    std::mutex mutex;       // buffers are per thread, output is shared
 
 private:
     Trace();
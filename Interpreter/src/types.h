@@ -2,7 +2,6 @@
 
 #include <string>
 #include <vector>
+#include "../include/node_value.h"
 
-class CSyntaxNode;
-
-typedef std::vector<CSyntaxNode*> VarValue;
\ No newline at end of file
+typedef NodeValue VarValue;
\ No newline at end of file
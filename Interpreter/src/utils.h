@@ -14,12 +14,3 @@ void COLOR(unsigned short color);
 
 bool isNumber(std::string str);
 bool isAlphaNumeric(std::string str);
-
-struct Token;
-namespace Tokenizer {
-    std::string compressWhiteSpaces(std::string str);
-    std::string separateTokens(std::string str, std::vector<std::string> delimiters);
-
-    std::vector<Token> tokenize(std::string str, int line_number);
-    std::vector<Token> getTokensFromFile(std::string path, std::vector<std::string> delimiters);
-}
@@ -4,84 +4,123 @@
 #include "utils.h"
 #include "trace.h"
 #include "types.h"
+#include "frames.h"
+#include <algorithm>
 #include <sstream>
 
 
 using namespace std;
 
 VariableSet::VariableSet() 
+    : slots(nullptr), layout(nullptr)
 {
 }
 
-void VariableSet::Add(std::string id, VarValue value)
+VariableSet::VariableSet(VariableSlot* frame, const FrameLayout& frameLayout)
+    : slots(frame), layout(&frameLayout)
 {
-    Args[id] = value;
 }
 
-void VariableSet::PushReturn(VarValue val)
-{
-    _return = val;
-}
 
-VarValue VariableSet::PopReturn()
+string VariableSet::ToStr(Interpreter const & interpreter) const
 {
-    return _return;
-}
+    stringstream ss;
 
-void VariableSet::Remove(std::string id)
-{
-    auto it = Args.find(id);
-    if (it != Args.end())
+    ss << "(";
+
+    for (size_t i = 0; layout && i < layout->names.size(); i++)
     {
-        Args.erase(it);
+        if (!slots[i].defined) continue;
+
+        ss << " " << Symbols::Name(layout->names[i]) << " ";   /// append variable name 
+
+        ss << interpreter.ValToStr(slots[i].value);
+
+        ss << " ";
     }
-}
+    /*
+    ss << " return ";
+    ss << ValToStr(_return);
+    ss << " ";
+    */
+    ss << ")";
 
-void VariableSet::Clear()
-{
-    Args.clear();
-    _return.clear();
+    return ss.str();
 }
 
-bool VariableSet::Exists(std::string id) const
+
+
+static const size_t FRAME_BLOCK_SLOTS = 4096;
+
+FrameStack::FrameStack()
+    : top(0)
 {
-    return Args.find(id) != Args.end();
 }
 
-VarValue VariableSet::GetValue(std::string id) const
+VariableSet FrameStack::Push(const FrameLayout& layout)
 {
-    VarValue val;
+    size_t count = layout.names.size();
 
-    auto it = Args.find(id);
-    if (it != Args.end())
+    while (blocks.empty() || blocks[top].used + count > blocks[top].size)
     {
-        val = it->second;
+        if (!blocks.empty() && blocks[top].used > 0)
+        {
+            top++;      // the rest of this block stays unused until the frames above are popped
+        }
+
+        if (top == blocks.size())
+        {
+            size_t size = max(FRAME_BLOCK_SLOTS, count);
+            blocks.push_back({ unique_ptr<VariableSlot[]>(new VariableSlot[size]), size, 0 });
+        }
+        else if (blocks[top].size < count)  // an empty block too small for the frame
+        {
+            blocks[top].slots.reset(new VariableSlot[count]);
+            blocks[top].size = count;
+        }
     }
 
-    return val;
-}
+    Block& block = blocks[top];
+    VariableSlot* frame = block.slots.get() + block.used;
+    block.used += count;
 
+    for (size_t i = 0; i < count; i++)
+    {
+        frame[i].value.clear();
+        frame[i].defined = false;
+    }
 
-string VariableSet::ToStr(Interpreter const & interpreter) const
-{
-    stringstream ss;
+    return VariableSet(frame, layout);
+}
 
-    ss << "(";
+void FrameStack::Pop(const FrameLayout& layout)
+{
+    blocks[top].used -= layout.names.size();
 
-    for (auto arg : Args)
+    if (blocks[top].used == 0 && top > 0)
     {
-        ss << " " << arg.first << " ";   /// append variable name 
-
-        ss << interpreter.ValToStr(arg.second);
+        top--;      // the next frame to pop is the last one of the block below
+    }
+}
 
-        ss << " ";
+void FrameStack::Clear()
+{
+    for (auto& block : blocks)
+    {
+        for (size_t i = 0; i < block.size; i++)
+        {
+            block.slots[i].value.clear();
+            block.slots[i].defined = false;
+        }
     }
-    /*
-    ss << " return ";
-    ss << ValToStr(_return);
-    ss << " ";
-    */
-    ss << ")";
+}
 
-    return ss.str();
+CallFrame::CallFrame(FrameStack& frames, const FrameLayout& frameLayout)
+    : stack(frames), layout(frameLayout), variables(frames.Push(frameLayout))
+{
+}
+
+CallFrame::~CallFrame()
+{
+    stack.Pop(layout);
 }
\ No newline at end of file
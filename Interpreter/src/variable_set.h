@@ -1,28 +1,86 @@
 #pragma once
 
+#include <memory>
 #include <string>
-#include <map>
+#include <vector>
 #include "types.h"
+#include "symbols.h"
 
 class Interpreter;
+struct FrameLayout;
+
+struct VariableSlot
+{
+    VarValue value;
+    bool defined = false;
+};
+
+// Variables of a function call, one slot per variable of the function (frames.h). The slots live
+// on the FrameStack, a VariableSet only points to them and can be copied without copying values.
 class VariableSet
 {
 private:
     VarValue _return;
-    std::map<std::string, VarValue> Args;
+    VariableSlot* slots;
+    const FrameLayout* layout;      // names of the slots, for ToStr
 
 public:
-    void Add(std::string id, VarValue value);
-    void Remove(std::string id);
+    void Add(unsigned int slot, VarValue value) { slots[slot].value = std::move(value); slots[slot].defined = true; }
+    void Remove(unsigned int slot) { slots[slot].value.clear(); slots[slot].defined = false; }
 
-    VarValue GetValue(std::string id) const;
-    bool Exists(std::string id) const;
+    const VarValue& GetValue(unsigned int slot) const { return slots[slot].value; }
+    VarValue TakeValue(unsigned int slot) { return std::move(slots[slot].value); }     // for the return value, when the call ends
+    bool Exists(unsigned int slot) const { return slots[slot].defined; }
 
-    void PushReturn(VarValue val);
-    VarValue PopReturn();
+    void PushReturn(VarValue val) { _return = std::move(val); }
+    VarValue PopReturn() { return std::move(_return); }
     
-    void Clear();
     std::string ToStr(Interpreter const &) const;
 
     VariableSet();
+    VariableSet(VariableSlot* slots, const FrameLayout& layout);
+};
+
+// Frames of the calls in progress
+// ===============================
+// A call pushes a frame of the size of its layout on top of the frame of its caller and pops it
+// when it returns. The frames are kept in blocks that are never moved, a frame that does not fit
+// the rest of the block starts the next block. Slots are reset when a frame is pushed, so the
+// values stay allocated until the slot is used again and popping a frame costs nothing.
+class FrameStack
+{
+private:
+    struct Block
+    {
+        std::unique_ptr<VariableSlot[]> slots;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    size_t top;             // block of the last frame pushed
+
+public:
+    FrameStack();
+
+    VariableSet Push(const FrameLayout& layout);    // all slots undefined
+    void Pop(const FrameLayout& layout);
+    void Clear();           // destroys the values left in the slots, when the execution ends
+};
+
+// pushes a frame for the lifetime of the object, also when the call ends with an exception
+class CallFrame
+{
+private:
+    FrameStack& stack;
+    const FrameLayout& layout;
+
+public:
+    VariableSet variables;
+
+    CallFrame(FrameStack& stack, const FrameLayout& layout);
+    ~CallFrame();
+
+    CallFrame(const CallFrame&) = delete;
+    CallFrame& operator=(const CallFrame&) = delete;
 };
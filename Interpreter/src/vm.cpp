@@ -0,0 +1,410 @@
+#include "vm.h"
+#include "interpreter.h"
+#include "operation_exceptions.h"
+#include "trace.h"
+#include "utils.h"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+#if defined(__GNUC__)
+#define VM_COMPUTED_GOTO    // labels as values, other compilers dispatch with a switch
+#endif
+
+// a case is a block closed before VM_NEXT, a computed goto does not destroy the locals of the scopes it leaves
+#ifdef VM_COMPUTED_GOTO
+#define VM_CASE(name) L_##name:
+#define VM_NEXT { in = &code[pc++]; goto *labels[(size_t)in->op]; }
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_NEXT continue;
+#endif
+
+// a runtime error leaves the dispatch for the handler of the innermost call
+#define VM_FAIL(err) { error = err; goto failed; }
+
+
+
+Vm::Vm(Interpreter& interp)
+    : interpreter(interp), values(&interp.memory), loops(&interp.memory), handlers(&interp.memory)
+{
+}
+
+Expected<VarValue> Vm::Call(const Function& function, VarValue* args)
+{
+    RuntimeError error = function.Parse();
+    if (error) return error;
+
+    // the code of the table of the execution if it inlined callees into the function
+    const Expansion* expanded = interpreter.Expanded(function);
+    const Bytecode& bytecode = expanded ? expanded->code : function.Compiled();
+
+    _TRACE_("        CALL  >>>  " << function.getId() << endl);
+
+    const FrameLayout& layout = expanded ? expanded->frame : function.Frame();
+    CallFrame call(interpreter.frames, layout);
+
+    for (size_t i = 0; i < layout.params.size(); i++)
+    {
+        call.variables.Add(layout.params[i], move(args[i]));
+    }
+
+    call.variables.Add(layout.result, VarValue()); // add variable for function return value
+
+    error = Run(bytecode, call.variables);
+    if (error) return error;
+
+    return call.variables.TakeValue(layout.result);
+}
+
+RuntimeError Vm::Run(const Bytecode& bytecode, VariableSet& frame)
+{
+    static const VarValue TRUE_VALUE = VarValue::True();  // non empty value means true
+
+    const Instruction* code = bytecode.code.data();
+    const Instruction* in = code;
+    uint32_t pc = 0;
+
+    size_t handlersBase = handlers.size();     // the handlers of the calls in this function
+    RuntimeError error;
+
+    for (;;)
+    {
+        {
+#ifdef VM_COMPUTED_GOTO
+            static const void* const labels[] = {       // in the order of OpCode
+                &&L_PUSH_TRUE, &&L_PUSH_FALSE, &&L_LOAD_VAR, &&L_LOAD_SLOT, &&L_NULL_CHECK, &&L_NULL_CHECK_SLOT,
+                &&L_STORE_VAR, &&L_POP, &&L_NOT,
+                &&L_ALL, &&L_ANY, &&L_JUMP, &&L_JUMP_IF_FALSE, &&L_FOR_BEGIN, &&L_FOR_NEXT, &&L_FOR_END,
+                &&L_CALL_BEGIN, &&L_CALL, &&L_INLINE_BEGIN, &&L_INLINE_END, &&L_CLEAR, &&L_PRINTS, &&L_PRINT, &&L_CONDITIONS_OF, &&L_PARENT, &&L_GET_NODES,
+                &&L_ATTR_CHECK, &&L_COMPARE_ATTR, &&L_RETURN,
+            };
+
+            VM_NEXT
+#else
+            for (;;)
+            {
+            in = &code[pc++];
+
+            switch (in->op)
+            {
+#endif
+            VM_CASE(PUSH_TRUE)
+            {
+                values.push_back(TRUE_VALUE);
+            }
+            VM_NEXT
+            VM_CASE(PUSH_FALSE)
+            {
+                values.emplace_back();
+            }
+            VM_NEXT
+            VM_CASE(LOAD_VAR)
+            {
+                if (!frame.Exists(in->a))
+                {
+                    stringstream ss;
+                    ss << "Undefined variable: " << Symbols::Name(in->b) << " @line: " << bytecode.tokens[pc - 1].line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                values.push_back(frame.GetValue(in->a));
+            }
+            VM_NEXT
+            VM_CASE(LOAD_SLOT)
+            {
+                values.push_back(frame.GetValue(in->a));
+            }
+            VM_NEXT
+            VM_CASE(NULL_CHECK)
+            {
+                if (!frame.Exists(in->a))
+                {
+                    stringstream ss;
+                    ss << "Undefined variable: " << Symbols::Name(in->b) << " @line: " << bytecode.tokens[pc - 1].line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                bool null = frame.GetValue(in->a).empty();
+                values.push_back(null ? TRUE_VALUE : VarValue());
+            }
+            VM_NEXT
+            VM_CASE(NULL_CHECK_SLOT)
+            {
+                bool null = frame.GetValue(in->a).empty();
+                values.push_back(null ? TRUE_VALUE : VarValue());
+            }
+            VM_NEXT
+            VM_CASE(STORE_VAR)
+            {
+                frame.Add(in->a, move(values.back()));
+                values.pop_back();
+            }
+            VM_NEXT
+            VM_CASE(POP)
+            {
+                values.pop_back();
+            }
+            VM_NEXT
+            VM_CASE(NOT)
+            {
+                values.back() = values.back().empty() ? TRUE_VALUE : VarValue();
+            }
+            VM_NEXT
+            VM_CASE(ALL)
+            {
+                bool result = true;
+                for (auto it = values.end() - in->a; it != values.end(); it++) result = result && !it->empty();
+
+                values.resize(values.size() - in->a);
+                values.push_back(result ? TRUE_VALUE : VarValue());
+            }
+            VM_NEXT
+            VM_CASE(ANY)
+            {
+                bool result = false;
+                for (auto it = values.end() - in->a; it != values.end(); it++) result = result || !it->empty();
+
+                values.resize(values.size() - in->a);
+                values.push_back(result ? TRUE_VALUE : VarValue());
+            }
+            VM_NEXT
+            VM_CASE(JUMP)
+            {
+                pc = in->b;
+            }
+            VM_NEXT
+            VM_CASE(JUMP_IF_FALSE)
+            {
+                bool condition = !values.back().empty(); // empty vector means false
+                values.pop_back();
+
+                if (!condition) pc = in->b;
+            }
+            VM_NEXT
+            VM_CASE(FOR_BEGIN)
+            {
+                loops.push_back({ move(values.back()), 0 });
+                values.pop_back();
+            }
+            VM_NEXT
+            VM_CASE(FOR_NEXT)
+            {
+                Loop& loop = loops.back();
+
+                if (loop.next < loop.items.size())
+                {
+                    frame.Add(in->a, VarValue(loop.items[loop.next++]));
+                }
+                else
+                {
+                    loops.pop_back();
+                    pc = in->b;
+                }
+            }
+            VM_NEXT
+            VM_CASE(FOR_END)
+            {
+                frame.Remove(in->a);
+                pc = in->b;
+            }
+            VM_NEXT
+            VM_CASE(CALL_BEGIN)
+            {
+                const Function* function = interpreter.Callee(in->a);
+                const TokenInfo& t = bytecode.tokens[pc - 1];
+
+                if (!function)
+                {
+                    stringstream ss;
+                    ss << "Function with name \"" << Symbols::Name(in->a) << "\" not defined! @Line: " << t.line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                uint32_t paramCount = code[in->b].b;
+
+                if (paramCount != function->getParams().size())
+                {
+                    stringstream ss;
+                    ss << "Function with name \"" << Symbols::Name(in->a) << "\" called with " << paramCount
+                       << " parameters instead of " << function->getParams().size() << ". @Line: " << t.line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                handlers.push_back({ function, values.size(), loops.size(), in->b + 1 });
+
+                error = function->Parse();  // a body that does not parse fails the call before its arguments are evaluated
+                if (error) goto failed;
+            }
+            VM_NEXT
+            VM_CASE(CALL)
+            {
+                const Function* function = handlers.back().function;
+                VarValue* args = values.data() + values.size() - in->b;
+
+                // a pure function called with the same nodes before returns the value of that call
+                MemoKey key(*function);
+                bool memoized = interpreter.Memoized(in->a);
+
+                for (uint32_t i = 0; i < in->b && memoized; i++)
+                {
+                    memoized = key.Add(args[i]);
+                }
+
+                const VarValue* known = memoized ? interpreter.memo.Find(key) : nullptr;
+                size_t handled = interpreter.memo.Errors();
+
+                // the arguments are moved to the frame of the call before the stack grows again
+                Expected<VarValue> result = known ? Expected<VarValue>(*known) : Call(*function, args);
+                if (result.Failed()) VM_FAIL(move(result.Error()));
+
+                if (memoized && !known && interpreter.memo.Errors() == handled) interpreter.memo.Store(key, result.Value());
+
+                values.resize(values.size() - in->b);
+
+                handlers.pop_back();
+                values.push_back(move(result.Value()));
+            }
+            VM_NEXT
+            VM_CASE(INLINE_BEGIN)
+            {
+                handlers.push_back({ nullptr, values.size(), loops.size(), in->b });
+            }
+            VM_NEXT
+            VM_CASE(INLINE_END)
+            {
+                handlers.pop_back();
+            }
+            VM_NEXT
+            VM_CASE(CLEAR)
+            {
+                for (uint32_t slot = in->a; slot < in->a + in->b; slot++) frame.Remove(slot);
+            }
+            VM_NEXT
+            VM_CASE(PRINTS)
+            {
+                const string& msg = bytecode.strings[in->a];
+
+                if (0 == msg.compare("endl"))
+                {
+                    cout << std::endl;
+                }
+                else
+                {
+                    _TRACE_(msg << endl);
+
+                    YELLOW(msg);
+                }
+            }
+            VM_NEXT
+            VM_CASE(PRINT)
+            {
+                for (auto node : values.back())
+                {
+                    auto attribs = interpreter.adapter->GetAttributesOf(node);
+
+                    if (attribs)
+                    {
+                        YELLOW(attribs->ToString());
+                        _TRACE_(attribs->ToString() << endl);
+                    }
+                }
+
+                values.pop_back();
+            }
+            VM_NEXT
+            VM_CASE(CONDITIONS_OF)
+            {
+                VarValue& val = values.back();
+                const TokenInfo& t = bytecode.tokens[pc - 1];
+
+                if (val.empty())
+                {
+                    stringstream ss;
+                    ss << t.tok << " called with expression which returned nothing. @Line: " << t.line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                if (0 == val[0])
+                {
+                    stringstream ss;
+                    ss << "Operation " << t.tok << " parameter is NULL pointer. @Line: " << t.line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                val = VarValue(interpreter.adapter->GetGeogConds(val[0]), &interpreter.memory);
+            }
+            VM_NEXT
+            VM_CASE(PARENT)
+            {
+                VarValue& val = values.back();
+
+                if (!val.empty())
+                {
+                    val = VarValue(interpreter.adapter->GetParentsForNode(val[0]), &interpreter.memory);
+                }
+            }
+            VM_NEXT
+            VM_CASE(GET_NODES)
+            {
+                const string& typeName = bytecode.strings[in->a];
+
+                if (!interpreter.adapter->Exists(typeName))
+                {
+                    const TokenInfo& t = bytecode.tokens[pc - 1];
+
+                    stringstream ss;
+                    ss << "Parameter \"" << typeName << "\" of " << t.tok << " is not a known Node Type. @Line: " << t.line;
+                    VM_FAIL(RuntimeError(ss.str()));
+                }
+
+                values.push_back(VarValue(interpreter.adapter->GetAllNodesOfType(typeName, 0), &interpreter.memory));
+            }
+            VM_NEXT
+            VM_CASE(ATTR_CHECK)
+            {
+                auto check = static_cast<const AttributeCheck*>(bytecode.operations[in->a]);
+                Expected<VarValue> result = check->Evaluate(frame, interpreter.adapter, in->b);
+                if (result.Failed()) VM_FAIL(move(result.Error()));
+
+                values.push_back(move(result.Value()));
+            }
+            VM_NEXT
+            VM_CASE(COMPARE_ATTR)
+            {
+                auto compare = static_cast<const CompareAttribute*>(bytecode.operations[in->a]);
+                Expected<VarValue> result = compare->Evaluate(frame, interpreter.adapter, in->b);
+                if (result.Failed()) VM_FAIL(move(result.Error()));
+
+                values.push_back(move(result.Value()));
+            }
+            VM_NEXT
+            VM_CASE(RETURN)
+            {
+                return RuntimeError();
+            }
+#ifndef VM_COMPUTED_GOTO
+            default:
+                throw OperationBugException(BUG_LOCATION);
+            }
+            }
+#endif
+        }
+
+    failed:
+        if (handlers.size() == handlersBase) return error;  // no call in progress here, the caller handles it
+
+        Handler handler = move(handlers.back());
+        handlers.pop_back();
+
+        values.resize(handler.values);
+        loops.resize(handler.loops);
+        values.emplace_back();  // the call returns nothing
+        pc = handler.resume;
+
+        interpreter.memo.Handled();
+        RED("RUNTIME ERROR: " << error.what());
+        _TRACE_("        RUNTIME ERROR: " << error.what() << endl);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "bytecode.h"
+#include "operations.h"
+#include "variable_set.h"
+
+class Interpreter;
+
+// Stack machine running compiled functions
+// ========================================
+// Values are passed on a stack instead of the return slot of the interpreter, every call runs with
+// its own set of variables. A runtime error is handled by the innermost call in progress, like in
+// FunctionCall::Exec: the call returns an empty value and the caller goes on. The error is a jump
+// to the handler in the same Run, or the status Run returns to the CALL of its caller. A body the
+// inliner wrote into its caller (function_table.h) has a handler of its own, like the call it replaces.
+class Vm
+{
+private:
+    struct Loop
+    {
+        VarValue items;
+        size_t next;
+    };
+
+    struct Handler              // a call between CALL_BEGIN and CALL, or an inlined body between INLINE_BEGIN and INLINE_END
+    {
+        const Function* function;   // kept alive by the table of the execution, null for an inlined body
+        size_t values;          // stack sizes when the call began
+        size_t loops;
+        uint32_t resume;        // instruction after the CALL
+    };
+
+    Interpreter& interpreter;
+    std::pmr::vector<VarValue> values;     // in the memory of the execution
+    std::pmr::vector<Loop> loops;
+    std::pmr::vector<Handler> handlers;
+
+private:
+    RuntimeError Run(const Bytecode& bytecode, VariableSet& frame);
+
+public:
+    Vm(Interpreter& interpreter);
+
+    Expected<VarValue> Call(const Function& function, VarValue* args);  // moves the arguments, returns the runtime error no call handled
+};
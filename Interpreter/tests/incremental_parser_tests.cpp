@@ -0,0 +1,248 @@
+#include "test.h"
+#include "script_interpreter.h"
+#include "../src/arena.h"
+#include "../src/incremental_parser.h"
+#include "../src/parser.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+    const char RULES[] =
+        "; three functions\n"
+        "@Depth(n):\n"
+        "    #b = PARENT(#n)\n"
+        "    @Depth = FALSE\n"
+        "    IF #b == NULL THEN\n"
+        "        @Depth = TRUE\n"
+        "    ELSE\n"
+        "        @Depth = @Depth(#b)\n"
+        "    END\n"
+        "END\n"
+        "\n"
+        "@Pick(x, y):\n"
+        "    @Pick = #x OR #y\n"
+        "END\n"
+        "\n"
+        "@Root:\n"
+        "    @Root = TRUE\n"
+        "    FOR #z IN GET_NODES_OF_TYPE(Zone)\n"
+        "        @Root = #Root AND @Depth(#z) AND @Pick(#z, FALSE)\n"
+        "    END\n"
+        "END\n";
+
+    bool SameFunctions(const vector<RuleFunction>& expected, const vector<RuleFunction>& actual)
+    {
+        if (expected.size() != actual.size()) return false;
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (expected[i].name != actual[i].name || expected[i].parameters != actual[i].parameters || expected[i].line != actual[i].line) return false;
+        }
+        return true;
+    }
+
+    // the line of the function holds its name
+    bool DefinedAt(const string& text, const RuleFunction& function)
+    {
+        size_t begin = 0;
+        for (int line = 1; line < function.line && begin != string::npos; line++)
+        {
+            begin = text.find('\n', begin);
+            if (begin != string::npos) begin++;
+        }
+        if (begin == string::npos) return false;
+
+        return text.substr(begin, text.find('\n', begin) - begin).find("@" + function.name) != string::npos;
+    }
+
+    // the functions of a parse of the whole text, as the interpreter loads a file
+    vector<FUNC_PTR> FullParse(const string& text)
+    {
+        LangParser parser;
+        ParseResult result = parser.parse(SourceFile::FromText("editor.rul", text));
+        CHECK(result.error.empty());
+        return result.functions;
+    }
+
+    // the editor must show what a new editor of its text shows
+    void CheckAgainstNewEditor(RuleEditor& editor)
+    {
+        RuleEditor fresh("editor.rul", editor.GetText());
+
+        CHECK(SameFunctions(fresh.GetFunctions(), editor.GetFunctions()));
+        CHECK(fresh.GetErrors() == editor.GetErrors());
+    }
+
+    // lines of the function names and of the calls in their bodies
+    vector<int> Lines(const vector<FUNC_PTR>& functions)
+    {
+        vector<int> lines;
+        for (auto& function : functions)
+        {
+            lines.push_back(function->t.line);
+            for (auto& call : function->Frame().calls) lines.push_back(call.line);
+        }
+        return lines;
+    }
+}
+
+TEST(EditorFunctionsMatchAFullParse)
+{
+    RuleEditor editor("editor.rul", RULES);
+
+    vector<RuleFunction> functions = editor.GetFunctions();
+    vector<FUNC_PTR> full = FullParse(RULES);
+
+    CHECK_EQUAL(full.size(), functions.size());
+    for (size_t i = 0; i < full.size() && i < functions.size(); i++)
+    {
+        CHECK(functions[i].name == full[i]->getId());
+        CHECK_EQUAL(full[i]->t.line, functions[i].line);
+    }
+    CHECK(editor.GetErrors().empty());
+}
+
+TEST(EditorMovesLaterFunctionsWhenLinesAreAdded)
+{
+    RuleEditor editor("editor.rul", RULES);
+
+    // three new lines in the body of Depth
+    unsigned int at = (unsigned int)string(RULES).find("    @Depth = FALSE");
+    editor.Edit(at, at, "    #c = #b\n    #d = #c\n\n");
+
+    CHECK(editor.GetErrors().empty());
+    CHECK_EQUAL(15, editor.GetFunctions()[1].line);
+    CheckAgainstNewEditor(editor);
+
+    vector<FUNC_PTR> full = FullParse(editor.GetText());
+    CHECK_EQUAL(full[2]->t.line, editor.GetFunctions()[2].line);
+}
+
+TEST(EditorMovesLaterFunctionsWhenLinesAreRemoved)
+{
+    RuleEditor editor("editor.rul", RULES);
+
+    // the comment line and the ELSE branch of Depth
+    string text = RULES;
+    unsigned int elseBegin = (unsigned int)text.find("    ELSE");
+    unsigned int elseEnd = (unsigned int)text.find("    END");
+    editor.Edit(elseBegin, elseEnd, "");
+    editor.Edit(0, (unsigned int)text.find('\n') + 1, "");
+
+    CHECK(editor.GetErrors().empty());
+    CheckAgainstNewEditor(editor);
+
+    vector<RuleFunction> functions = editor.GetFunctions();
+    vector<FUNC_PTR> full = FullParse(editor.GetText());
+    CHECK_EQUAL(3u, functions.size());
+    for (size_t i = 0; i < full.size() && i < functions.size(); i++) CHECK_EQUAL(full[i]->t.line, functions[i].line);
+}
+
+TEST(EditorMovesTheLinesOfBodiesToo)
+{
+    IncrementalParser parser("editor.rul", RULES);
+
+    parser.Edit(0, 0, "\n\n; moved\n");
+    unsigned int at = (unsigned int)parser.Text().find("@Pick(x, y):");
+    parser.Edit(at, at, "; Pick\n");
+
+    CHECK(parser.Errors().empty());
+    CHECK(Lines(FullParse(parser.Text())) == Lines(parser.Functions()));
+}
+
+TEST(EditorErrorsHaveCurrentLines)
+{
+    RuleEditor editor("editor.rul", RULES);
+
+    // the END of Pick is missing, then lines are added above it
+    unsigned int at = (unsigned int)editor.GetText().find("    @Pick = #x OR #y\nEND\n") + 21;
+    editor.Edit(at, at + 4, "");
+    CHECK(!editor.GetErrors().empty());
+
+    editor.Edit(0, 0, "\n\n");
+    CheckAgainstNewEditor(editor);
+
+    editor.Edit(0, 2, "");
+    editor.Edit(at, at, "END\n");
+    CHECK(editor.GetErrors().empty());
+    CheckAgainstNewEditor(editor);
+}
+
+TEST(EditorMatchesANewEditorAfterRandomEdits)
+{
+    const char* pieces[] = { "\n", "\n\n", "END\n", "@Extra(p):\n", "    @Extra = TRUE\n", "    #v = #p\n", "; note\n", "(", " ", "x" };
+
+    auto editor = make_unique<RuleEditor>("editor.rul", RULES);
+    mt19937 random(7);
+
+    for (int step = 0; step < 300; step++)
+    {
+        const string text = editor->GetText();
+        unsigned int begin = (unsigned int)(random() % (text.size() + 1));
+
+        if (random() % 3 == 0 && begin < text.size())
+        {
+            unsigned int end = min((unsigned int)text.size(), begin + 1 + (unsigned int)(random() % 30));
+            editor->Edit(begin, end, "");
+        }
+        else
+        {
+            editor->Edit(begin, begin, pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))]);
+        }
+
+        // the parse of a new editor stops at the first error of a span, the editor also keeps the spans
+        // that were split before the error was typed. The lines of its functions must be current anyway.
+        RuleEditor fresh("editor.rul", editor->GetText());
+        vector<RuleFunction> functions = editor->GetFunctions();
+        StrVec errors = editor->GetErrors();
+        bool same = true;
+
+        if (fresh.GetErrors().empty())
+        {
+            same = errors.empty() && SameFunctions(fresh.GetFunctions(), functions);
+        }
+        for (auto& error : fresh.GetErrors())
+        {
+            same = same && find(errors.begin(), errors.end(), error) != errors.end();
+        }
+        for (auto& expected : fresh.GetFunctions())
+        {
+            same = same && any_of(functions.begin(), functions.end(), [&](const RuleFunction& f) { return SameFunctions({ expected }, { f }); });
+        }
+        for (auto& function : functions)
+        {
+            same = same && DefinedAt(editor->GetText(), function);
+        }
+
+        if (!same)
+        {
+            Tests::Fail("edit " + to_string(step) + " differs from a new editor of the text", __FILE__, __LINE__);
+            return;
+        }
+
+        if (step % 50 == 49) editor = make_unique<RuleEditor>("editor.rul", RULES);
+    }
+}
+
+TEST(ArenaShiftsEveryLocation)
+{
+    OperationArena arena;
+    vector<const TokenInfo*> locations;
+
+    // more than a block of locations, between child lists of the operations
+    for (int line = 1; line <= 500; line++)
+    {
+        locations.push_back(&arena.Locate({ "x", line }));
+        arena.List(vector<OP_PTR>(line % 4));
+    }
+
+    arena.ShiftLines(-3);
+
+    bool shifted = true;
+    for (int i = 0; i < (int)locations.size(); i++) shifted = shifted && locations[i]->line == i + 1 - 3 && locations[i]->tok == "x";
+    CHECK(shifted);
+}
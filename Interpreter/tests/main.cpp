@@ -0,0 +1,60 @@
+#include "test.h"
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+// usage: Tests [name...]    runs all tests, or the named ones; the exit code is the number of failed tests
+
+namespace
+{
+    int failures = 0;       // of the running test
+}
+
+vector<Tests::Test>& Tests::All()
+{
+    static vector<Test> tests;
+    return tests;
+}
+
+bool Tests::Register(const char* name, function<void()> run)
+{
+    All().push_back({ name, run });
+    return true;
+}
+
+void Tests::Fail(const string& message, const char* file, int line)
+{
+    cerr << "    " << file << "(" << line << "): " << message << endl;
+    failures++;
+}
+
+int main(int argc, char** argv)
+{
+    vector<string> names(argv + 1, argv + argc);
+    int failed = 0, run = 0;
+
+    for (auto& test : Tests::All())
+    {
+        bool selected = names.empty();
+        for (auto& name : names) selected = selected || name == test.name;
+        if (!selected) continue;
+
+        failures = 0;
+        try
+        {
+            test.run();
+        }
+        catch (const exception& e)
+        {
+            Tests::Fail(string("exception: ") + e.what(), __FILE__, __LINE__);
+        }
+
+        cerr << (failures ? "FAILED " : "ok     ") << test.name << endl;
+        failed += failures ? 1 : 0;
+        run++;
+    }
+
+    cerr << run - failed << " of " << run << " tests passed" << endl;
+    return failed;
+}
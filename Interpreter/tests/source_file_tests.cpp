@@ -0,0 +1,73 @@
+#include "test.h"
+#include "../src/function_table.h"
+#include "../src/parser.h"
+#include "../src/source_file.h"
+#include <cstdio>
+#include <fstream>
+
+using namespace std;
+
+namespace
+{
+    const char RULE_FILE[] = "source_file_tests.rul";
+
+    void WriteFile(const char* path, const string& text)
+    {
+        ofstream(path, ios::out | ios::binary) << text;
+    }
+}
+
+TEST(RuleFilesAreMapped)
+{
+    const string text = "@Mapped:\n    @Mapped = TRUE\nEND\n";
+    WriteFile(RULE_FILE, text);
+    {
+        SOURCE_PTR source = SourceFile::Open(RULE_FILE);
+
+        CHECK(source->IsMapped());
+        CHECK(source->Text() == text);
+    }
+    remove(RULE_FILE);
+}
+
+TEST(EmptyRuleFilesAreRead)
+{
+    WriteFile(RULE_FILE, "");
+    {
+        SOURCE_PTR source = SourceFile::Open(RULE_FILE);
+
+        CHECK(!source->IsMapped());
+        CHECK(source->Text().empty());
+    }
+    remove(RULE_FILE);
+}
+
+TEST(FunctionTableKeepsTheRuleFiles)
+{
+    WriteFile(RULE_FILE, "@KeptFirst:\n    @KeptFirst = @KeptSecond\nEND\n@KeptSecond:\n    @KeptSecond = TRUE\nEND\n");
+
+    weak_ptr<const SourceFile> file;
+    {
+        unique_ptr<FunctionTable> table;
+        {
+            LangParser parser;
+            ParseResult parsed = parser.parse(string(RULE_FILE));
+            CHECK(parsed.error.empty());
+            CHECK_EQUAL(2u, parsed.functions.size());
+            if (parsed.functions.empty()) return;
+
+            file = parsed.functions[0]->Source();
+            CHECK(file.lock()->IsMapped());
+
+            FunctionTable::Definitions definitions;
+            for (auto& function : parsed.functions) definitions.emplace(string(function->getId()), function);
+            table = make_unique<FunctionTable>(definitions, 16);
+        }
+
+        CHECK(!file.expired());
+        CHECK(table->Find("KeptFirst") != nullptr);
+    }
+    CHECK(file.expired());
+
+    remove(RULE_FILE);
+}
@@ -0,0 +1,118 @@
+#include "test.h"
+#include "../src/function_table.h"
+#include "../src/incremental_parser.h"
+#include "../src/symbols.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+    const char EDITOR_TEXT[] =
+        "@EditorOnly(first):\n"
+        "    #second = #first\n"
+        "    @EditorOnly = #second\n"
+        "END\n";
+
+    bool HasName(const vector<SymbolId>& ids, string_view name)
+    {
+        return any_of(ids.begin(), ids.end(), [&](SymbolId id) { return Symbols::Name(id) == name; });
+    }
+}
+
+TEST(SessionNamesAfterParse)
+{
+    IncrementalParser parser("editor.rul", EDITOR_TEXT);
+
+    vector<FUNC_PTR> functions = parser.Functions();
+    CHECK_EQUAL(1u, functions.size());
+    if (functions.empty()) return;
+
+    const Function& function = *functions[0];
+    CHECK(function.getSymbol() >= symFIRST_SESSION);
+    CHECK(function.getId() == "EditorOnly");
+    CHECK(HasName(function.getParams(), "first"));
+    CHECK(HasName(function.Frame().names, "second"));
+
+    // on a thread that never parsed
+    string name;
+    thread reader([&]() { name = string(function.getId()); });
+    reader.join();
+    CHECK_EQUAL(string("EditorOnly"), name);
+}
+
+TEST(SessionNamesStayAfterEdits)
+{
+    IncrementalParser parser("editor.rul", EDITOR_TEXT);
+    FUNC_PTR before = parser.Functions()[0];
+
+    // typing a second parameter name one character at a time
+    unsigned int at = (unsigned int)string(EDITOR_TEXT).find(')');
+    string typed = ", third";
+    for (size_t i = 0; i < typed.size(); i++)
+    {
+        parser.Edit(at + (unsigned int)i, at + (unsigned int)i, typed.substr(i, 1));
+    }
+
+    CHECK(parser.Errors().empty());
+    CHECK(before->getId() == "EditorOnly");
+
+    vector<FUNC_PTR> after = parser.Functions();
+    CHECK_EQUAL(1u, after.size());
+    if (!after.empty()) CHECK(HasName(after[0]->getParams(), "third"));
+}
+
+TEST(SessionNamesStayOutOfTheProcessTable)
+{
+    SymbolId first = Symbols::Intern("SessionTestFirst");
+
+    {
+        IncrementalParser parser("editor.rul", EDITOR_TEXT);
+        parser.Edit(0, 0, "@Partia");
+        parser.Edit(7, 7, "l:\nEND\n");
+    }
+
+    CHECK_EQUAL(first + 1, Symbols::Intern("SessionTestSecond"));
+}
+
+TEST(SessionKeepsTheIdsOfLoadedNames)
+{
+    SymbolId loaded = Symbols::Intern("LoadedByTheInterpreter");
+
+    IncrementalParser parser("editor.rul", "@LoadedByTheInterpreter:\n    @LoadedByTheInterpreter = TRUE\nEND\n");
+    vector<FUNC_PTR> functions = parser.Functions();
+
+    CHECK_EQUAL(1u, functions.size());
+    if (!functions.empty()) CHECK_EQUAL(loaded, functions[0]->getSymbol());
+}
+
+TEST(SessionNamesEndWithTheParser)
+{
+    FUNC_PTR function;
+    {
+        IncrementalParser parser("editor.rul", EDITOR_TEXT);
+        function = parser.Functions()[0];
+    }
+    CHECK(function->getId().empty());
+}
+
+TEST(FunctionTableRejectsSessionFunctions)
+{
+    IncrementalParser parser("editor.rul", EDITOR_TEXT);
+
+    FunctionTable::Definitions definitions;
+    definitions.emplace("EditorOnly", parser.Functions()[0]);
+
+    bool rejected = false;
+    try
+    {
+        FunctionTable table(definitions);
+    }
+    catch (const invalid_argument&)
+    {
+        rejected = true;
+    }
+    CHECK(rejected);
+}
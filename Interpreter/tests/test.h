@@ -0,0 +1,32 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Tests of the interpreter internals
+// ==================================
+// TEST(name) { ... } defines a test that main.cpp runs, CHECK(condition) records a failure and lets
+// the test go on. A test that throws fails with the message of the exception.
+namespace Tests {
+    struct Test
+    {
+        const char* name;
+        std::function<void()> run;
+    };
+
+    std::vector<Test>& All();
+    bool Register(const char* name, std::function<void()> run);
+    void Fail(const std::string& message, const char* file, int line);
+}
+
+#define TEST(name) \
+    static void name(); \
+    static const bool name##Registered = Tests::Register(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) Tests::Fail("CHECK(" #condition ")", __FILE__, __LINE__); } while (false)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { if (!((expected) == (actual))) Tests::Fail("CHECK_EQUAL(" #expected ", " #actual ")", __FILE__, __LINE__); } while (false)